@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/workqueue.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -48,6 +49,10 @@
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
 
+/* Longest wait for a command's completion interrupt.  The ATA
+   standards allow a disk this long to come out of a reset. */
+#define COMPLETION_TIMEOUT_NS (30 * NS_PER_SEC)
+
 /* An ATA device. */
 struct disk {
 	char name[8];               /* Name, e.g. "hd0:1". */
@@ -72,6 +77,9 @@ struct channel {
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
 	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+	struct ktimer completion_timer;     /* Ends the wait if no interrupt comes. */
+	bool timed_out;                     /* Did the last wait time out? */
+	struct work unexpected_work;        /* Reports an unexpected interrupt. */
 
 	struct disk devices[2];     /* The devices on this channel. */
 };
@@ -86,6 +94,8 @@ static void identify_ata_device (struct disk *);
 
 static void select_sector (struct disk *, disk_sector_t);
 static void issue_pio_command (struct channel *, uint8_t command);
+static bool wait_for_completion (struct channel *);
+static ktimer_func completion_timeout;
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
 
@@ -95,6 +105,7 @@ static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
+static work_func report_unexpected;
 
 /* Initialize the disk subsystem and detect disks. */
 void
@@ -121,7 +132,9 @@ disk_init (void) {
 		}
 		lock_init (&c->lock);
 		c->expecting_interrupt = false;
+		work_init (&c->unexpected_work, report_unexpected, c);
 		sema_init (&c->completion_wait, 0);
+		ktimer_init (&c->completion_timer);
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -218,7 +231,8 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
+	if (!wait_for_completion (c))
+		PANIC ("%s: disk read timed out, sector=%"PRDSNu, d->name, sec_no);
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
 	input_sector (c, buffer);
@@ -245,7 +259,8 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
 	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
+	if (!wait_for_completion (c))
+		PANIC ("%s: disk write timed out, sector=%"PRDSNu, d->name, sec_no);
 	d->write_cnt++;
 	lock_release (&c->lock);
 }
@@ -354,8 +369,7 @@ identify_ata_device (struct disk *d) {
 	   into our buffer. */
 	select_device_wait (d);
 	issue_pio_command (c, CMD_IDENTIFY_DEVICE);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d)) {
+	if (!wait_for_completion (c) || !wait_while_busy (d)) {
 		d->is_ata = false;
 		return;
 	}
@@ -432,6 +446,34 @@ issue_pio_command (struct channel *c, uint8_t command) {
 	outb (reg_command (c), command);
 }
 
+/* Waits for the completion interrupt of the command just issued
+   on channel C.  Returns true if it came, false if it did not
+   come within COMPLETION_TIMEOUT_NS.  Either the interrupt or the
+   timeout, whichever is first, clears expecting_interrupt, so
+   the other finds nothing to do. */
+static bool
+wait_for_completion (struct channel *c) {
+	c->timed_out = false;
+	timer_add (&c->completion_timer, timer_ns () + COMPLETION_TIMEOUT_NS,
+			completion_timeout, c);
+	sema_down (&c->completion_wait);
+	timer_cancel (&c->completion_timer);
+	return !c->timed_out;
+}
+
+/* ktimer_func that gives up on channel C_'s completion
+   interrupt. */
+static void
+completion_timeout (void *c_) {
+	struct channel *c = c_;
+
+	if (c->expecting_interrupt) {
+		c->expecting_interrupt = false;
+		c->timed_out = true;
+		sema_up (&c->completion_wait);
+	}
+}
+
 /* Reads a sector from channel C's data register in PIO mode into
    SECTOR, which must have room for DISK_SECTOR_SIZE bytes. */
 static void
@@ -520,15 +562,27 @@ interrupt_handler (struct intr_frame *f) {
 		if (f->vec_no == c->irq) {
 			if (c->expecting_interrupt) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
+				c->expecting_interrupt = false;
 				sema_up (&c->completion_wait);      /* Wake up waiter. */
-			} else
-				printf ("%s: unexpected interrupt\n", c->name);
+			} else {
+				inb (reg_status (c));               /* Acknowledge interrupt. */
+				queue_work (&c->unexpected_work);
+			}
 			return;
 		}
 
 	NOT_REACHED ();
 }
 
+/* Reports an unexpected interrupt on channel C_, outside the
+   interrupt handler, since printing is slow. */
+static void
+report_unexpected (void *c_) {
+	struct channel *c = c_;
+
+	printf ("%s: unexpected interrupt\n", c->name);
+}
+
 static void
 inspect_read_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
@@ -3,20 +3,20 @@
 #include "devices/intq.h"
 #include "devices/serial.h"
 
-/* Stores keys from the keyboard and serial port. */
+/* Stores keys from the keyboard and serial port.  Protected by
+   serial_lock. */
 static struct intq buffer;
 
 /* Initializes the input buffer. */
 void
 input_init (void) {
-	intq_init (&buffer);
+	intq_init (&buffer, &serial_lock);
 }
 
 /* Adds a key to the input buffer.
-   Interrupts must be off and the buffer must not be full. */
+   serial_lock must be held and the buffer must not be full. */
 void
 input_putc (uint8_t key) {
-	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (!intq_full (&buffer));
 
 	intq_putc (&buffer, key);
@@ -31,8 +31,10 @@ input_getc (void) {
 	uint8_t key;
 
 	old_level = intr_disable ();
+	spin_lock (&serial_lock);
 	key = intq_getc (&buffer);
 	serial_notify ();
+	spin_unlock (&serial_lock);
 	intr_set_level (old_level);
 
 	return key;
@@ -40,9 +42,8 @@ input_getc (void) {
 
 /* Returns true if the input buffer is full,
    false otherwise.
-   Interrupts must be off. */
+   serial_lock must be held. */
 bool
 input_full (void) {
-	ASSERT (intr_get_level () == INTR_OFF);
 	return intq_full (&buffer);
 }
@@ -6,10 +6,11 @@ static int next (int pos);
 static void wait (struct intq *q, struct thread **waiter);
 static void signal (struct intq *q, struct thread **waiter);
 
-/* Initializes interrupt queue Q. */
+/* Initializes interrupt queue Q, protected by spin lock GUARD. */
 void
-intq_init (struct intq *q) {
+intq_init (struct intq *q, struct spinlock *guard) {
 	lock_init (&q->lock);
+	q->guard = guard;
 	q->not_full = q->not_empty = NULL;
 	q->head = q->tail = 0;
 }
@@ -17,31 +18,36 @@ intq_init (struct intq *q) {
 /* Returns true if Q is empty, false otherwise. */
 bool
 intq_empty (const struct intq *q) {
-	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spin_held_by_current_cpu (q->guard));
 	return q->head == q->tail;
 }
 
 /* Returns true if Q is full, false otherwise. */
 bool
 intq_full (const struct intq *q) {
-	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spin_held_by_current_cpu (q->guard));
 	return next (q->head) == q->tail;
 }
 
 /* Removes a byte from Q and returns it.
    Q must not be empty if called from an interrupt handler.
    Otherwise, if Q is empty, first sleeps until a byte is
-   added. */
+   added.  Q->lock may sleep, so the guard is released while
+   taking and dropping it. */
 uint8_t
 intq_getc (struct intq *q) {
 	uint8_t byte;
 
-	ASSERT (intr_get_level () == INTR_OFF);
 	while (intq_empty (q)) {
 		ASSERT (!intr_context ());
+		spin_unlock (q->guard);
 		lock_acquire (&q->lock);
-		wait (q, &q->not_empty);
+		spin_lock (q->guard);
+		if (intq_empty (q))
+			wait (q, &q->not_empty);
+		spin_unlock (q->guard);
 		lock_release (&q->lock);
+		spin_lock (q->guard);
 	}
 
 	byte = q->buf[q->tail];
@@ -56,12 +62,16 @@ intq_getc (struct intq *q) {
    removed. */
 void
 intq_putc (struct intq *q, uint8_t byte) {
-	ASSERT (intr_get_level () == INTR_OFF);
 	while (intq_full (q)) {
 		ASSERT (!intr_context ());
+		spin_unlock (q->guard);
 		lock_acquire (&q->lock);
-		wait (q, &q->not_full);
+		spin_lock (q->guard);
+		if (intq_full (q))
+			wait (q, &q->not_full);
+		spin_unlock (q->guard);
 		lock_release (&q->lock);
+		spin_lock (q->guard);
 	}
 
 	q->buf[q->head] = byte;
@@ -78,14 +88,13 @@ next (int pos) {
 /* WAITER must be the address of Q's not_empty or not_full
    member.  Waits until the given condition is true. */
 static void
-wait (struct intq *q UNUSED, struct thread **waiter) {
+wait (struct intq *q, struct thread **waiter) {
 	ASSERT (!intr_context ());
-	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT ((waiter == &q->not_empty && intq_empty (q))
 			|| (waiter == &q->not_full && intq_full (q)));
 
 	*waiter = thread_current ();
-	thread_block ();
+	thread_block_locked (q->guard);
 }
 
 /* WAITER must be the address of Q's not_empty or not_full
@@ -94,7 +103,6 @@ wait (struct intq *q UNUSED, struct thread **waiter) {
    the waiting thread. */
 static void
 signal (struct intq *q UNUSED, struct thread **waiter) {
-	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT ((waiter == &q->not_empty && !intq_empty (q))
 			|| (waiter == &q->not_full && !intq_full (q)));
 
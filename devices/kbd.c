@@ -4,8 +4,10 @@
 #include <stdio.h>
 #include <string.h>
 #include "devices/input.h"
+#include "devices/serial.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/workqueue.h"
 
 /* Keyboard data register port. */
 #define DATA_REG 0x60
@@ -23,11 +25,21 @@ static bool caps_lock;
 /* Number of keys pressed. */
 static int64_t key_cnt;
 
+/* Scancodes read by the interrupt handler and not yet decoded
+   by keyboard_work().  Protected by turning interrupts off. */
+#define SCANCODE_CNT 64         /* Must be a power of 2. */
+static unsigned scancodes[SCANCODE_CNT];
+static unsigned scancode_head, scancode_tail;
+static struct work kbd_work;
+
 static intr_handler_func keyboard_interrupt;
+static work_func keyboard_work;
+static void decode_scancode (unsigned code);
 
 /* Initializes the keyboard. */
 void
 kbd_init (void) {
+	work_init (&kbd_work, keyboard_work, NULL);
 	intr_register_ext (0x21, keyboard_interrupt, "8042 Keyboard");
 }
 
@@ -84,27 +96,53 @@ static const struct keymap shifted_keymap[] = {
 
 static bool map_key (const struct keymap[], unsigned scancode, uint8_t *);
 
+/* Keyboard interrupt handler.  Only reads the scancode, which
+   acknowledges the interrupt, and leaves decoding it to
+   keyboard_work(). */
 static void
 keyboard_interrupt (struct intr_frame *args UNUSED) {
+	unsigned code;
+
+	/* Read scancode, including second byte if prefix code. */
+	code = inb (DATA_REG);
+	if (code == 0xe0)
+		code = (code << 8) | inb (DATA_REG);
+
+	/* Drop the key if the buffer is full, as input_putc() would. */
+	if (scancode_head - scancode_tail < SCANCODE_CNT)
+		scancodes[scancode_head++ % SCANCODE_CNT] = code;
+	queue_work (&kbd_work);
+}
+
+/* Decodes the scancodes queued by keyboard_interrupt().  The
+   input buffer needs serial_lock, which also keeps two workers
+   from decoding at once. */
+static void
+keyboard_work (void *aux UNUSED) {
+	enum intr_level old_level = intr_disable ();
+
+	spin_lock (&serial_lock);
+	while (scancode_tail != scancode_head)
+		decode_scancode (scancodes[scancode_tail++ % SCANCODE_CNT]);
+	spin_unlock (&serial_lock);
+	intr_set_level (old_level);
+}
+
+/* Updates the shift state, or adds a character to the input
+   buffer, for scancode CODE.  serial_lock must be held. */
+static void
+decode_scancode (unsigned code) {
 	/* Status of shift keys. */
 	bool shift = left_shift || right_shift;
 	bool alt = left_alt || right_alt;
 	bool ctrl = left_ctrl || right_ctrl;
 
-	/* Keyboard scancode. */
-	unsigned code;
-
 	/* False if key pressed, true if key released. */
 	bool release;
 
 	/* Character that corresponds to `code'. */
 	uint8_t c;
 
-	/* Read scancode, including second byte if prefix code. */
-	code = inb (DATA_REG);
-	if (code == 0xe0)
-		code = (code << 8) | inb (DATA_REG);
-
 	/* Bit 0x80 distinguishes key press from key release
 	   (even if there's a prefix). */
 	release = (code & 0x80) != 0;
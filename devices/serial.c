@@ -54,6 +54,13 @@ static enum { UNINIT, POLL, QUEUE } mode;
 /* Data to be transmitted. */
 static struct intq txq;
 
+/* Protects the serial port, txq and, since the serial port feeds
+   it and stops receiving while it is full, the input buffer in
+   input.c.  A static spin lock starts out released, so the
+   serial port can be used before anything is initialized. */
+struct spinlock serial_lock;
+
+static bool serial_lock_acquire (void);
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
 static void write_ier (void);
@@ -70,7 +77,7 @@ init_poll (void) {
 	outb (FCR_REG, 0);                    /* Disable FIFO. */
 	set_serial (115200);                  /* 115.2 kbps, N-8-1. */
 	outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-	intq_init (&txq);
+	intq_init (&txq, &serial_lock);
 	mode = POLL;
 }
 
@@ -88,7 +95,9 @@ serial_init_queue (void) {
 	intr_register_ext (0x20 + 4, serial_interrupt, "serial");
 	mode = QUEUE;
 	old_level = intr_disable ();
+	spin_lock (&serial_lock);
 	write_ier ();
+	spin_unlock (&serial_lock);
 	intr_set_level (old_level);
 }
 
@@ -96,6 +105,7 @@ serial_init_queue (void) {
 void
 serial_putc (uint8_t byte) {
 	enum intr_level old_level = intr_disable ();
+	bool locked = serial_lock_acquire ();
 
 	if (mode != QUEUE) {
 		/* If we're not set up for interrupt-driven I/O yet,
@@ -119,6 +129,8 @@ serial_putc (uint8_t byte) {
 		write_ier ();
 	}
 
+	if (locked)
+		spin_unlock (&serial_lock);
 	intr_set_level (old_level);
 }
 
@@ -127,18 +139,34 @@ serial_putc (uint8_t byte) {
 void
 serial_flush (void) {
 	enum intr_level old_level = intr_disable ();
+	bool locked = serial_lock_acquire ();
+
 	while (!intq_empty (&txq))
 		putc_poll (intq_getc (&txq));
+	if (locked)
+		spin_unlock (&serial_lock);
 	intr_set_level (old_level);
 }
 
+/* Acquires serial_lock and returns true, unless this CPU already
+   holds it, which can only be because it panicked while holding
+   it.  Then returns false, so that the panic message still gets
+   out.  Interrupts must be off. */
+static bool
+serial_lock_acquire (void) {
+	if (spin_held_by_current_cpu (&serial_lock))
+		return false;
+	spin_lock (&serial_lock);
+	return true;
+}
+
 /* The fullness of the input buffer may have changed.  Reassess
    whether we should block receive interrupts.
    Called by the input buffer routines when characters are added
    to or removed from the buffer. */
 void
 serial_notify (void) {
-	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spin_held_by_current_cpu (&serial_lock));
 	if (mode == QUEUE)
 		write_ier ();
 }
@@ -167,7 +195,7 @@ static void
 write_ier (void) {
 	uint8_t ier = 0;
 
-	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spin_held_by_current_cpu (&serial_lock));
 
 	/* Enable transmit interrupt if we have any characters to
 	   transmit. */
@@ -198,6 +226,7 @@ static void
 serial_interrupt (struct intr_frame *f UNUSED) {
 	/* Inquire about interrupt in UART.  Without this, we can
 	   occasionally miss an interrupt running under QEMU. */
+	spin_lock (&serial_lock);
 	inb (IIR_REG);
 
 	/* As long as we have room to receive a byte, and the hardware
@@ -212,4 +241,5 @@ serial_interrupt (struct intr_frame *f UNUSED) {
 
 	/* Update interrupt enable register based on queue status. */
 	write_ier ();
+	spin_unlock (&serial_lock);
 }
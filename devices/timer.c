@@ -3,10 +3,13 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -25,7 +28,71 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* 8254 input frequency, and the counter value that makes it
+   interrupt TIMER_FREQ times per second, rounded to nearest. */
+#define PIT_HZ 1193180
+#define PIT_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Largest count that the 16-bit counter can be loaded with. */
+#define PIT_MAX_COUNT 0xffff
+
+/* If false (default), the timer interrupts every tick.
+   If true, the idle thread stops the periodic tick and programs
+   a one-shot interrupt for the next sleeper's wake tick instead.
+   Controlled by kernel command-line option "-nohz". */
+bool timer_nohz;
+
+/* One-shot state, for tickless idle and kernel timers.  While
+   ONESHOT_ARMED, counter 0 is in one-shot mode and will interrupt
+   ONESHOT_COUNT counts after it was armed.  The first tick
+   boundary falls ONESHOT_FIRST counts after arming and later ones
+   every PIT_COUNT counts.  Tickless idle expires on one of these
+   boundaries; a kernel timer may expire between them, and then
+   ONESHOT_OFFGRID tells timer_interrupt() that its interrupt is
+   not a tick.  See timer_nohz_exit(). */
+static bool oneshot_armed;
+static unsigned oneshot_count;
+static unsigned oneshot_first;
+static bool oneshot_offgrid;
+
+/* Pending kernel timers, earliest deadline first, and the one
+   whose function ktimer_run() is calling, if any. */
+static struct heap ktimers;
+static struct ktimer *ktimer_running;
+
+/* Protects the one-shot state, the kernel timers and the 8254,
+   which any CPU may reprogram through timer_add().  Kernel timer
+   functions are called without it, so that they may add timers
+   and wake threads. */
+static struct spinlock timer_lock;
+
+/* Time stamp counter rate, in counts per millisecond, measured
+   by timer_calibrate().  Until then it is 0, and timer_ns() only
+   counts whole ticks.  TSC_BASE is the counter at calibration
+   and NS_BASE the time then. */
+static uint64_t tsc_per_ms;
+static uint64_t tsc_base;
+static int64_t ns_base;
+
+/* Sleeps shorter than this busy-wait instead of blocking, since
+   blocking and reprogramming the timer would take about as
+   long. */
+#define SLEEP_SPIN_NS 20000
+
+/* Number of tick interrupts suppressed while idle. */
+static int64_t nohz_skipped_ticks;
+
 static intr_handler_func timer_interrupt;
+static void pit_set_periodic (void);
+static void pit_set_oneshot (unsigned count);
+static unsigned pit_read_count (void);
+static bool pit_oneshot_expired (void);
+static heap_less_func ktimer_later;
+static void ktimer_run (void);
+static void ktimer_program (void);
+static unsigned ns_to_counts (int64_t ns);
+static void wake_sleeper (void *sema);
+static void tsc_calibrate (void);
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -52,19 +119,11 @@ static void real_time_sleep (int64_t num, int32_t denom);
 // 이를 통해 커널은 일정한 주기로 타이머 인터럽트를 받아 시간 관련 작업을 수행
 void
 timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to nearest.
-	   8254 입력 주파수를 TIMER_FREQ로 나눈 값, 반올림한 값입니다. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ; // TIMER_FREQ = 100;
-
-	// 8254 PIT의 컨트롤 레지스터(Command Word, CW)에 값을 출력하여 타이머 설정을 지정
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	// "counter 0": PIT의 카운터 0을 설정하겠다는 의미.
-	// "LSB then MSB": 카운터 값을 LSB(Low-Byte)와 MSB(High-Byte)로 나누어 입력할 것.
-	// "mode 2": PIT의 작동 모드를 2로 설정 (Rate Generator 모드).
-	// "binary": 카운터 값을 이진(binary)으로 처리하겠다는 의미.
-
-	outb (0x40, count & 0xff);	// PIT의 카운터 0의 LSB(Low-Byte)에 count 값을 설정
-	outb (0x40, count >> 8);	// PIT의 카운터 0의 MSB(High-Byte)에 count 값을 설정
+	/* Interrupt every PIT_COUNT counts, that is, TIMER_FREQ times
+	   per second.  타이머를 Rate Generator 모드로 설정합니다. */
+	pit_set_periodic ();
+	heap_init (&ktimers, ktimer_later, NULL);
+	spin_init (&timer_lock);
 
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 	//  PIT에서 발생하는 인터럽트를 등록
@@ -93,6 +152,32 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	tsc_calibrate ();
+}
+
+/* Measures tsc_per_ms, for timer_ns(), by reading the time stamp
+   counter a few ticks apart, starting at a tick boundary. */
+static void
+tsc_calibrate (void) {
+	const int calibrate_ticks = 5;
+	enum intr_level old_level;
+	int64_t start;
+	uint64_t tsc;
+
+	start = timer_ticks ();
+	while (timer_ticks () == start)
+		barrier ();
+	start = timer_ticks ();
+	tsc = rdtsc ();
+	while (timer_elapsed (start) < calibrate_ticks)
+		barrier ();
+
+	old_level = intr_disable ();
+	tsc_base = rdtsc ();
+	ns_base = ticks * NS_PER_TICK;
+	tsc_per_ms = (tsc_base - tsc) / (calibrate_ticks * 1000 / TIMER_FREQ);
+	intr_set_level (old_level);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -114,6 +199,94 @@ timer_elapsed (int64_t then) { // 맨 처음은 0
 	return timer_ticks () - then; // 현재 ticks 반환, then은 start -> 최대 ticks에 도달하면 0이 되겠지, 
 }
 
+/* Returns the number of nanoseconds since the OS booted, as
+   measured by the time stamp counter.  Before timer_calibrate(),
+   only whole ticks are counted. */
+int64_t
+timer_ns (void) {
+	uint64_t cycles;
+
+	if (tsc_per_ms == 0)
+		return timer_ticks () * NS_PER_TICK;
+
+	/* Split the division so that the multiplication cannot
+	   overflow. */
+	cycles = rdtsc () - tsc_base;
+	return ns_base + cycles / tsc_per_ms * 1000000
+		+ cycles % tsc_per_ms * 1000000 / tsc_per_ms;
+}
+
+/* Initializes kernel timer T as not pending. */
+void
+ktimer_init (struct ktimer *t) {
+	ASSERT (t != NULL);
+
+	t->pending = false;
+}
+
+/* Arranges for FUNC(AUX) to be called from the timer interrupt
+   as soon as timer_ns() reaches DEADLINE_NS.  T must have been
+   initialized with ktimer_init() and must not be pending.  It
+   must stay valid until FUNC is called or timer_cancel(T)
+   returns.  May be called from an interrupt
+   handler, including from a kernel timer's function.
+
+   Pending timers are kept in a heap by deadline.  Whenever the
+   earliest of them is due before the next tick, the 8254 is put
+   into one-shot mode to interrupt at that deadline, so a timer
+   fires within a few microseconds of it rather than at the next
+   tick. */
+void
+timer_add (struct ktimer *t, int64_t deadline_ns, ktimer_func *func,
+		void *aux) {
+	enum intr_level old_level;
+
+	ASSERT (t != NULL);
+	ASSERT (func != NULL);
+
+	old_level = intr_disable ();
+	spin_lock (&timer_lock);
+	ASSERT (!t->pending);
+	t->deadline = deadline_ns;
+	t->func = func;
+	t->aux = aux;
+	t->pending = true;
+	heap_insert (&ktimers, &t->elem);
+	if (heap_max (&ktimers) == &t->elem)
+		ktimer_program ();
+	spin_unlock (&timer_lock);
+	intr_set_level (old_level);
+}
+
+/* Cancels kernel timer T.  Returns true if T was pending, false
+   if it had already run or was never added.  If T's function is
+   running on another CPU, waits for it to return, so that T may
+   be reused or freed at once.  A one-shot armed for T is left
+   alone: when it fires, there is nothing to do. */
+bool
+timer_cancel (struct ktimer *t) {
+	enum intr_level old_level;
+	bool was_pending;
+
+	ASSERT (t != NULL);
+
+	old_level = intr_disable ();
+	spin_lock (&timer_lock);
+	while (ktimer_running == t && !intr_context ()) {
+		spin_unlock (&timer_lock);
+		asm volatile ("pause");
+		spin_lock (&timer_lock);
+	}
+	was_pending = t->pending;
+	if (was_pending) {
+		heap_remove (&ktimers, &t->elem);
+		t->pending = false;
+	}
+	spin_unlock (&timer_lock);
+	intr_set_level (old_level);
+	return was_pending;
+}
+
 
 
 
@@ -131,6 +304,21 @@ timer_sleep (int64_t ticks) { // 우리가 현재 슬립 시켜주고 싶은 tic
 	// while (timer_elapsed (start) < ticks)	// start로 부터 얼마나 시간이 지났는 지 반환해서 ticks랑 비교해서 
 	// 	thread_yield ();					// 양보를 함 -> 스케줄링이 일어나면서, 시간을 씀, 원래 쓰레드로 스위칭
 }
+
+/* Suspends execution for at least MIN_TICKS and at most about
+   MAX_TICKS timer ticks.  Within that window the thread is woken
+   together with other sleepers, so callers that do not need an
+   exact wake-up time should prefer this to timer_sleep(): it
+   saves wake-ups and thread switches.  Interrupts must be
+   turned on. */
+void
+timer_sleep_range (int64_t min_ticks, int64_t max_ticks) {
+	int64_t start = timer_ticks ();
+
+	ASSERT (intr_get_level () == INTR_ON);
+	ASSERT (min_ticks <= max_ticks);
+	thread_sleep_range (start + min_ticks, start + max_ticks);
+}
 // 바로 wake하지 말고, 대기하고 레디
 
 
@@ -163,15 +351,286 @@ timer_nsleep (int64_t ns) {
 void
 timer_print_stats (void) {
 	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	if (timer_nohz)
+		printf ("Timer: %"PRId64" ticks without interrupt while idle\n",
+				nohz_skipped_ticks);
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  If the next event the kernel is waiting for, tick
+   WAKE_TICK, is more than one tick away, stops the periodic tick
+   and arms a one-shot interrupt for WAKE_TICK instead, as far out
+   as the 16-bit counter allows, or for the earliest kernel timer
+   if that comes first.  The ticks skipped this way are made up by
+   timer_nohz_exit(). */
+void
+timer_nohz_enter (int64_t wake_tick) {
+	int64_t delta, max_delta;
+	unsigned first;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!timer_nohz)
+		return;
+	delta = wake_tick - ticks;
+	if (delta <= 1)
+		return;
+
+	spin_lock (&timer_lock);
+	first = pit_read_count ();
+	max_delta = 1 + (PIT_MAX_COUNT - first) / PIT_COUNT;
+	if (delta > max_delta)
+		delta = max_delta;
+	if (oneshot_armed || delta <= 1) {
+		spin_unlock (&timer_lock);
+		return;
+	}
+
+	oneshot_first = first;
+	oneshot_count = first + (delta - 1) * PIT_COUNT;
+	if (!heap_empty (&ktimers)) {
+		struct ktimer *t = heap_entry (heap_max (&ktimers), struct ktimer, elem);
+		unsigned count = ns_to_counts (t->deadline - timer_ns ());
+
+		if (count < oneshot_count)
+			oneshot_count = count;
+	}
+	oneshot_armed = true;
+	pit_set_oneshot (oneshot_count);
+	spin_unlock (&timer_lock);
+}
+
+/* Called at the start of every external interrupt.  If a one-shot
+   set up by timer_nohz_enter() or for a kernel timer is armed,
+   accounts for the ticks that passed without an interrupt by
+   running thread_tick() for each of them.
+
+   If the one-shot has expired on a tick boundary, its interrupt
+   is being handled or is pending, and timer_interrupt() accounts
+   for that final tick itself, so we return the timer to its
+   periodic mode.  Otherwise we are between two ticks, because a
+   kernel timer's one-shot expired or another device woke us up,
+   so we arm a short one-shot up to the next tick boundary to stay
+   on the tick grid, and go periodic when it fires.
+
+   The 8254 only interrupts the BSP, which alone handles all of
+   this. */
+void
+timer_nohz_exit (void) {
+	bool expired;
+	unsigned elapsed;
+	int64_t missed;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* ONESHOT_ARMED is read without the lock first, so that the
+	   common case stays cheap; it is checked again below. */
+	if (!oneshot_armed || cpu_current ()->id != 0)
+		return;
+	spin_lock (&timer_lock);
+	if (!oneshot_armed) {
+		spin_unlock (&timer_lock);
+		return;
+	}
+	oneshot_armed = false;
+
+	expired = pit_oneshot_expired ();
+	elapsed = expired ? oneshot_count : oneshot_count - pit_read_count ();
+	missed = elapsed < oneshot_first
+		? 0 : 1 + (elapsed - oneshot_first) / PIT_COUNT;
+
+	if (expired && missed > 0 && (elapsed - oneshot_first) % PIT_COUNT == 0) {
+		/* If the interrupt for an earlier one-shot that expired
+		   between ticks has not been handled yet, it has merged
+		   with this one, which is a tick. */
+		missed--;
+		oneshot_offgrid = false;
+		pit_set_periodic ();
+	} else {
+		unsigned next = elapsed < oneshot_first
+			? oneshot_first - elapsed
+			: PIT_COUNT - (elapsed - oneshot_first) % PIT_COUNT;
+
+		if (expired)
+			oneshot_offgrid = true;
+		oneshot_first = oneshot_count = next;
+		oneshot_armed = true;
+		pit_set_oneshot (next);
+	}
+	spin_unlock (&timer_lock);
+
+	if (missed > 0) {
+		nohz_skipped_ticks += missed;
+		while (missed-- > 0) {
+			ticks++;
+			thread_tick ();
+		}
+		thread_wake (ticks);
+		workqueue_tick (ticks);
+	}
 }
 
-/* Timer interrupt handler. */
+/* Timer interrupt handler.  Counts a tick, unless this is a
+   kernel timer's one-shot expiring between ticks, and runs the
+   kernel timers that are due. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
-	ticks++;
-	thread_tick ();
-	thread_wake (ticks);
+	bool offgrid;
+
+	spin_lock (&timer_lock);
+	offgrid = oneshot_offgrid;
+	oneshot_offgrid = false;
+	spin_unlock (&timer_lock);
+
+	if (!offgrid) {
+		ticks++;
+		thread_tick ();
+		thread_wake (ticks);
+		workqueue_tick (ticks);
+	}
+	ktimer_run ();
+}
+
+/* heap_less_func for kernel timers: true if A is due after B,
+   so that the earliest deadline is the greatest element. */
+static bool
+ktimer_later (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct ktimer, elem)->deadline
+		> heap_entry (b, struct ktimer, elem)->deadline;
+}
+
+/* Runs every kernel timer that is due, then arms the 8254 for the
+   next one.  A timer whose function adds it again for a time that
+   is already past runs again at the next interrupt, not in this
+   loop. */
+static void
+ktimer_run (void) {
+	int64_t now = timer_ns ();
+
+	spin_lock (&timer_lock);
+	while (!heap_empty (&ktimers)) {
+		struct ktimer *t = heap_entry (heap_max (&ktimers), struct ktimer, elem);
+		ktimer_func *func = t->func;
+		void *aux = t->aux;
+
+		if (t->deadline > now)
+			break;
+		heap_pop_max (&ktimers);
+		t->pending = false;
+		ktimer_running = t;
+		spin_unlock (&timer_lock);
+
+		func (aux);
+
+		spin_lock (&timer_lock);
+		ktimer_running = NULL;
+	}
+	ktimer_program ();
+	spin_unlock (&timer_lock);
+}
+
+/* If the earliest kernel timer is due before the 8254 next
+   interrupts, arms a one-shot for it.  Leaves a one-shot that has
+   already expired alone, since its interrupt is on the way and
+   will call here again.  A one-shot that spans several ticks, set
+   by timer_nohz_enter(), cannot be armed here: timer_nohz_exit()
+   replaces it as soon as anything but the idle thread runs on the
+   BSP, and other CPUs do not enter tickless idle.  timer_lock
+   must be held. */
+static void
+ktimer_program (void) {
+	struct ktimer *t;
+	unsigned count, next;
+
+	ASSERT (spin_held_by_current_cpu (&timer_lock));
+
+	if (heap_empty (&ktimers))
+		return;
+	t = heap_entry (heap_max (&ktimers), struct ktimer, elem);
+	count = ns_to_counts (t->deadline - timer_ns ());
+
+	if (!oneshot_armed) {
+		/* Periodic: the counter holds the counts left to the next
+		   tick. */
+		next = pit_read_count ();
+		if (count >= next)
+			return;
+		oneshot_first = next;
+	} else {
+		unsigned elapsed;
+
+		if (pit_oneshot_expired ())
+			return;
+		elapsed = oneshot_count - pit_read_count ();
+		if (elapsed >= oneshot_first || count >= oneshot_count - elapsed)
+			return;
+		oneshot_first -= elapsed;
+	}
+	oneshot_count = count;
+	oneshot_armed = true;
+	pit_set_oneshot (count);
+}
+
+/* Returns the number of 8254 counts in NS nanoseconds, rounded
+   up, at least 1 and at most PIT_MAX_COUNT. */
+static unsigned
+ns_to_counts (int64_t ns) {
+	int64_t count;
+
+	if (ns <= 0)
+		return 1;
+	if (ns >= (int64_t) PIT_MAX_COUNT * NS_PER_SEC / PIT_HZ)
+		return PIT_MAX_COUNT;
+	count = (ns * PIT_HZ + NS_PER_SEC - 1) / NS_PER_SEC;
+	return count > 0 ? count : 1;
+}
+
+/* Puts counter 0 of the 8254 into rate generator mode, so that it
+   interrupts every PIT_COUNT counts, that is, TIMER_FREQ times per
+   second. */
+static void
+pit_set_periodic (void) {
+	// 8254 PIT의 컨트롤 레지스터(Command Word, CW)에 값을 출력하여 타이머 설정을 지정
+	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	// "counter 0": PIT의 카운터 0을 설정하겠다는 의미.
+	// "LSB then MSB": 카운터 값을 LSB(Low-Byte)와 MSB(High-Byte)로 나누어 입력할 것.
+	// "mode 2": PIT의 작동 모드를 2로 설정 (Rate Generator 모드).
+	// "binary": 카운터 값을 이진(binary)으로 처리하겠다는 의미.
 
+	outb (0x40, PIT_COUNT & 0xff);	// PIT의 카운터 0의 LSB(Low-Byte)에 count 값을 설정
+	outb (0x40, PIT_COUNT >> 8);	// PIT의 카운터 0의 MSB(High-Byte)에 count 값을 설정
+}
+
+/* Puts counter 0 of the 8254 into one-shot mode, so that it
+   interrupts once, COUNT counts from now. */
+static void
+pit_set_oneshot (unsigned count) {
+	ASSERT (count > 0 && count <= PIT_MAX_COUNT);
+
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Returns the current value of counter 0, that is, the number of
+   counts left until it next reaches its terminal count. */
+static unsigned
+pit_read_count (void) {
+	uint8_t lo, hi;
+
+	outb (0x43, 0x00);    /* CW: counter 0, latch count. */
+	lo = inb (0x40);
+	hi = inb (0x40);
+	return (hi << 8) | lo;
+}
+
+/* Returns true if counter 0, in one-shot mode, has reached its
+   terminal count, which is when its OUT pin goes high. */
+static bool
+pit_oneshot_expired (void) {
+	outb (0x43, 0xe2);    /* Read-back: latch status of counter 0. */
+	return (inb (0x40) & 0x80) != 0;
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -208,25 +667,33 @@ busy_wait (int64_t loops) {
 /* Sleep for approximately NUM/DENOM seconds. */
 static void
 real_time_sleep (int64_t num, int32_t denom) {
-	/* Convert NUM/DENOM seconds into timer ticks, rounding down.
-
-	   (NUM / DENOM) s
-	   ---------------------- = NUM * TIMER_FREQ / DENOM ticks.
-	   1 s / TIMER_FREQ ticks
-	   */
-	int64_t ticks = num * TIMER_FREQ / denom;
+	/* Convert NUM/DENOM seconds into nanoseconds.  DENOM divides
+	   NS_PER_SEC. */
+	int64_t ns = num * (NS_PER_SEC / denom);
 
 	ASSERT (intr_get_level () == INTR_ON);
-	if (ticks > 0) {
-		/* We're waiting for at least one full timer tick.  Use
-		   timer_sleep() because it will yield the CPU to other
-		   processes. */
-		timer_sleep (ticks);
+	if (ns >= SLEEP_SPIN_NS) {
+		/* Block until a kernel timer wakes us up, yielding the CPU
+		   to other processes meanwhile. */
+		struct ktimer t;
+		struct semaphore done;
+
+		ktimer_init (&t);
+		sema_init (&done, 0);
+		timer_add (&t, timer_ns () + ns, wake_sleeper, &done);
+		sema_down (&done);
 	} else {
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
+		/* Otherwise the wait is too short to be worth blocking, so
+		   use a busy-wait loop.  We scale the numerator and
+		   denominator down by 1000 to avoid the possibility of
+		   overflow. */
 		ASSERT (denom % 1000 == 0);
 		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
 }
+
+/* ktimer_func for real_time_sleep(): wakes up the sleeper. */
+static void
+wake_sleeper (void *sema) {
+	sema_up (sema);
+}
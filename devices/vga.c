@@ -5,6 +5,7 @@
 #include <string.h>
 #include "threads/io.h"
 #include "threads/interrupt.h"
+#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* VGA text screen support.  See [FREEVGA] for more information. */
@@ -25,6 +26,11 @@ static size_t cx, cy;
    The attribute at (x,y) is fb[y][x][1]. */
 static uint8_t (*fb)[COL_CNT][2];
 
+/* Protects the display and the cursor position.  A static spin
+   lock starts out released, so the display can be used before
+   anything is initialized. */
+static struct spinlock vga_lock;
+
 static void clear_row (size_t y);
 static void cls (void);
 static void newline (void);
@@ -48,8 +54,14 @@ init (void) {
 void
 vga_putc (int c) {
 	/* Disable interrupts to lock out interrupt handlers
-	   that might write to the console. */
+	   that might write to the console, and take vga_lock to lock
+	   out other CPUs.  This CPU holds it already only if it
+	   panicked while holding it; print the panic anyway. */
 	enum intr_level old_level = intr_disable ();
+	bool locked = !spin_held_by_current_cpu (&vga_lock);
+
+	if (locked)
+		spin_lock (&vga_lock);
 
 	init ();
 
@@ -88,6 +100,8 @@ vga_putc (int c) {
 	/* Update cursor position. */
 	move_cursor ();
 
+	if (locked)
+		spin_unlock (&vga_lock);
 	intr_set_level (old_level);
 }
 
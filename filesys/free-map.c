@@ -4,16 +4,22 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "threads/vmalloc.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per disk sector. */
 
-/* Initializes the free map. */
+/* Initializes the free map.  It takes a bit per sector, so for a
+ * large disk it comes from kvmalloc(). */
 void
 free_map_init (void) {
-	free_map = bitmap_create (disk_size (filesys_disk));
-	if (free_map == NULL)
+	size_t bit_cnt = disk_size (filesys_disk);
+	size_t buf_size = bitmap_buf_size (bit_cnt);
+	void *buf = kvmalloc (buf_size);
+
+	if (buf == NULL)
 		PANIC ("bitmap creation failed--disk is too large");
+	free_map = bitmap_create_in_buf (bit_cnt, buf, buf_size);
 	bitmap_mark (free_map, FREE_MAP_SECTOR);
 	bitmap_mark (free_map, ROOT_DIR_SECTOR);
 }
@@ -5,7 +5,11 @@
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
+#include "threads/rcu.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -29,6 +33,7 @@ bytes_to_sectors (off_t size) {
 /* In-memory inode. */
 struct inode {
 	struct list_elem elem;              /* Element in inode list. */
+	struct rcu_head rcu;                /* Frees the inode after a grace period. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
@@ -53,10 +58,27 @@ byte_to_sector (const struct inode *inode, off_t pos) {
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Serializes changes to open_inodes.  Almost every inode_open()
+ * finds its inode already open, so lookups take no lock at all:
+ * they walk the list under RCU, and a closed inode is only freed
+ * once no lookup can still be looking at it. */
+static struct lock open_inodes_lock;
+
+/* In-memory inodes.  Each embeds a sector-sized inode_disk, which
+ * malloc() would round up to a 1 kB block. */
+static struct kmem_cache *inode_cache;
+
+static struct inode *inode_find (disk_sector_t);
+static bool open_cnt_inc_not_zero (struct inode *);
+static rcu_func inode_free;
+
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	lock_init (&open_inodes_lock);
+	lock_set_name (&open_inodes_lock, "open inodes");
+	inode_cache = kmem_cache_create ("inode", sizeof (struct inode), 0, NULL);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,39 +123,91 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
 	struct inode *inode;
 
-	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
+	/* Check whether this inode is already open.  If it is, but
+	 * its last opener is closing it, it is as good as gone. */
+	rcu_read_lock ();
+	inode = inode_find (sector);
+	if (inode != NULL && !open_cnt_inc_not_zero (inode))
+		inode = NULL;
+	rcu_read_unlock ();
+	if (inode != NULL)
+		return inode;
+
+	/* Not open: take the lock and look again, since another
+	 * opener may have opened the same inode in the meantime. */
+	lock_acquire (&open_inodes_lock);
+	inode = inode_find (sector);
+	if (inode != NULL) {
+		inode_reopen (inode);
+		lock_release (&open_inodes_lock);
+		return inode;
 	}
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	inode = kmem_cache_alloc (inode_cache);
+	if (inode == NULL) {
+		lock_release (&open_inodes_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+	/* Initialize, then make it visible to lookups. */
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
 	disk_read (filesys_disk, inode->sector, &inode->data);
+	list_push_front_rcu (&open_inodes, &inode->elem);
+	lock_release (&open_inodes_lock);
 	return inode;
 }
 
+/* Returns the open inode for SECTOR, or a null pointer if there
+ * is none.  Must be called in an RCU read-side critical section
+ * or with open_inodes_lock held. */
+static struct inode *
+inode_find (disk_sector_t sector) {
+	struct list_elem *e;
+
+	for (e = list_begin_rcu (&open_inodes); e != list_end (&open_inodes);
+			e = list_next_rcu (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+		if (inode->sector == sector)
+			return inode;
+	}
+	return NULL;
+}
+
+/* Atomically increments INODE's open_cnt, unless it has already
+ * dropped to 0.  Returns true if successful, false otherwise.
+ * `lock cmpxchg' is atomic across CPUs.  See [IA32-v2a]
+ * "CMPXCHG". */
+static bool
+open_cnt_inc_not_zero (struct inode *inode) {
+	int cnt = *(volatile int *) &inode->open_cnt;
+
+	while (cnt != 0) {
+		int seen;
+
+		asm volatile ("lock cmpxchgl %2, %1"
+				: "=a" (seen), "+m" (inode->open_cnt)
+				: "r" (cnt + 1), "0" (cnt)
+				: "memory");
+		if (seen == cnt)
+			return true;
+		cnt = seen;
+	}
+	return false;
+}
+
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
+	/* Lookups in inode_open() may reopen concurrently, without
+	 * any lock, so the increment must be atomic. */
 	if (inode != NULL)
-		inode->open_cnt++;
+		asm volatile ("lock incl %0" : "+m" (inode->open_cnt) : : "memory");
 	return inode;
 }
 
@@ -148,14 +222,22 @@ inode_get_inumber (const struct inode *inode) {
  * If INODE was also a removed inode, frees its blocks. */
 void
 inode_close (struct inode *inode) {
+	int old_cnt = -1;
+
 	/* Ignore null pointer. */
 	if (inode == NULL)
 		return;
 
-	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
+	/* Release resources if this was the last opener.  Holding
+	 * open_inodes_lock keeps inode_open() from finding INODE
+	 * under the lock in between; a lookup that finds it without
+	 * the lock sees open_cnt at 0 and leaves it alone. */
+	lock_acquire (&open_inodes_lock);
+	asm volatile ("lock xaddl %0, %1"
+			: "+r" (old_cnt), "+m" (inode->open_cnt) : : "memory");
+	if (old_cnt == 1) {
 		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
+		list_remove_rcu (&inode->elem);
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
@@ -164,8 +246,16 @@ inode_close (struct inode *inode) {
 					bytes_to_sectors (inode->data.length)); 
 		}
 
-		free (inode); 
+		/* Lookups may still be looking at it. */
+		call_rcu (&inode->rcu, inode_free);
 	}
+	lock_release (&open_inodes_lock);
+}
+
+/* rcu_func that frees the inode that HEAD is embedded in. */
+static void
+inode_free (struct rcu_head *head) {
+	kmem_cache_free (inode_cache, rcu_entry (head, struct inode, rcu));
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
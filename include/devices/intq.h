@@ -9,7 +9,10 @@
 
    Interrupt queue functions can be called from kernel threads or
    from external interrupt handlers.  Except for intq_init(),
-   interrupts must be off in either case.
+   interrupts must be off in either case, and the caller must hold
+   the queue's guard, the spin lock passed to intq_init(), which
+   also keeps out other CPUs.  A thread that sleeps in the queue
+   releases the guard until it wakes up.
 
    The interrupt queue has the structure of a "monitor".  Locks
    and condition variables from threads/synch.h cannot be used in
@@ -23,6 +26,7 @@
 /* A circular queue of bytes. */
 struct intq {
 	/* Waiting threads. */
+	struct spinlock *guard;     /* Protects the queue. */
 	struct lock lock;           /* Only one thread may wait at once. */
 	struct thread *not_full;    /* Thread waiting for not-full condition. */
 	struct thread *not_empty;   /* Thread waiting for not-empty condition. */
@@ -33,7 +37,7 @@ struct intq {
 	int tail;                   /* Old data is read here. */
 };
 
-void intq_init (struct intq *);
+void intq_init (struct intq *, struct spinlock *guard);
 bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
 uint8_t intq_getc (struct intq *);
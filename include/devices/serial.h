@@ -2,6 +2,9 @@
 #define DEVICES_SERIAL_H
 
 #include <stdint.h>
+#include "threads/synch.h"
+
+extern struct spinlock serial_lock;
 
 void serial_init_queue (void);
 void serial_putc (uint8_t);
@@ -1,23 +1,56 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <heap.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* Nanoseconds per second and per timer tick. */
+#define NS_PER_SEC 1000000000LL
+#define NS_PER_TICK (NS_PER_SEC / TIMER_FREQ)
+
+/* A function for a kernel timer to call, given auxiliary data
+   AUX.  It runs in the timer interrupt, so it must not sleep. */
+typedef void ktimer_func (void *aux);
+
+/* Kernel timer.  See timer_add(). */
+struct ktimer {
+	struct heap_elem elem;      /* Element in the pending timers. */
+	int64_t deadline;           /* When to run, in timer_ns() time. */
+	ktimer_func *func;          /* Function to call. */
+	void *aux;                  /* Its argument. */
+	bool pending;               /* Added, and not yet run or cancelled? */
+};
+
+/* Tickless idle, controlled by kernel command-line option
+   "-nohz". */
+extern bool timer_nohz;
+
 void timer_init (void);
 void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_ns (void);
+
+void ktimer_init (struct ktimer *);
+void timer_add (struct ktimer *, int64_t deadline_ns, ktimer_func *,
+		void *aux);
+bool timer_cancel (struct ktimer *);
 
 void timer_sleep (int64_t ticks);
+void timer_sleep_range (int64_t min_ticks, int64_t max_ticks);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+void timer_nohz_enter (int64_t wake_tick);
+void timer_nohz_exit (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
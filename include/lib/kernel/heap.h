@@ -0,0 +1,66 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Pairing heap.
+ *
+ * A heap keeps a set of elements ordered by a caller-supplied
+ * comparison function and gives fast access to the greatest of
+ * them.  This one is a pairing heap: insertion is O(1), and
+ * removing the greatest element, or any other element, is
+ * O(log n) amortized.
+ *
+ * The heap does not notice when an element's key changes, since
+ * the key usually lives in the containing structure.  Call
+ * heap_update() after changing it.
+ *
+ * Like the list and hash table, the heap does no dynamic
+ * allocation.  Each structure that can be in a heap must embed
+ * a struct heap_elem member, and heap_entry converts it back to
+ * the containing structure.  See lib/kernel/list.h. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *prev;     /* Parent if first child, else previous sibling. */
+	struct heap_elem *next;     /* Next sibling. */
+	struct heap_elem *child;    /* First child. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+ * the structure that HEAP_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)                   \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->next             \
+		- offsetof (STRUCT, MEMBER.next)))
+
+/* Compares the value of two heap elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Greatest element, or NULL. */
+	size_t elem_cnt;            /* Number of elements. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_insert (struct heap *, struct heap_elem *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+struct heap_elem *heap_max (const struct heap *);
+struct heap_elem *heap_pop_max (struct heap *);
+
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
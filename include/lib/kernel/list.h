@@ -141,6 +141,18 @@ bool list_empty (struct list *);
 /* Miscellaneous. */
 void list_reverse (struct list *);
 
+/* Lists read under RCU.  Writers must still exclude each other,
+   but readers may walk the list forward with list_begin_rcu()
+   and list_next_rcu() while it changes, inside an RCU read-side
+   critical section.  A removed element must not be freed or
+   reused until a grace period has passed.  See threads/rcu.h. */
+struct list_elem *list_begin_rcu (struct list *);
+struct list_elem *list_next_rcu (struct list_elem *);
+void list_insert_rcu (struct list_elem *, struct list_elem *);
+void list_push_front_rcu (struct list *, struct list_elem *);
+void list_push_back_rcu (struct list *, struct list_elem *);
+void list_remove_rcu (struct list_elem *);
+
 /* Compares the value of two list elements A and B, given
    auxiliary data AUX.  Returns true if A is less than B, or
    false if A is greater than or equal to B. */
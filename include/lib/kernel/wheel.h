@@ -0,0 +1,80 @@
+#ifndef __LIB_KERNEL_WHEEL_H
+#define __LIB_KERNEL_WHEEL_H
+
+/* Hierarchical timing wheel.
+ *
+ * A timing wheel keeps a set of elements, each tagged with an
+ * expiry time measured in ticks, and hands them back once the
+ * wheel has been advanced past that time.  Unlike a sorted list,
+ * insertion and removal are O(1), and advancing the wheel by one
+ * tick costs O(1) amortized plus the cost of the elements that
+ * actually expire.
+ *
+ * The wheel has WHEEL_LEVELS levels of WHEEL_SIZE slots each.
+ * Level 0 holds elements that expire within the next WHEEL_SIZE
+ * ticks, one slot per tick.  Each slot of level N covers
+ * WHEEL_SIZE^N ticks.  Whenever the level-0 index wraps around,
+ * the next slot of level 1 is "cascaded", that is, its elements
+ * are re-inserted into level 0, and so on upward.  Elements that
+ * expire further out than the wheel can represent are parked in
+ * the last level and re-inserted until they come into range.
+ *
+ * Like the list and hash table, the wheel does no dynamic
+ * allocation.  Each structure that can be in a wheel must embed
+ * a struct wheel_elem member, and wheel_entry converts it back
+ * to the containing structure.  See lib/kernel/list.h. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "list.h"
+
+/* Wheel geometry: 4 levels of 64 slots cover 2^24 ticks, which
+ * is a little over 46 hours at 100 Hz. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4
+
+/* Wheel element. */
+struct wheel_elem {
+	struct list_elem list_elem; /* Slot list element. */
+	int64_t expires;            /* Tick at which the element expires. */
+};
+
+/* Converts pointer to wheel element WHEEL_ELEM into a pointer to
+ * the structure that WHEEL_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the wheel element. */
+#define wheel_entry(WHEEL_ELEM, STRUCT, MEMBER)                 \
+	((STRUCT *) ((uint8_t *) &(WHEEL_ELEM)->list_elem       \
+		- offsetof (STRUCT, MEMBER.list_elem)))
+
+/* Performs some operation on expired wheel element E, given
+ * auxiliary data AUX.  E has already been removed from the
+ * wheel, so it may be re-inserted. */
+typedef void wheel_action_func (struct wheel_elem *e, void *aux);
+
+/* Timing wheel. */
+struct wheel {
+	int64_t base;               /* Next tick to be processed. */
+	size_t elem_cnt;            /* Number of pending elements. */
+	struct list slots[WHEEL_LEVELS][WHEEL_SIZE];
+};
+
+void wheel_init (struct wheel *, int64_t now);
+void wheel_elem_init (struct wheel_elem *);
+
+void wheel_insert (struct wheel *, struct wheel_elem *, int64_t expires);
+void wheel_remove (struct wheel *, struct wheel_elem *);
+void wheel_rearm (struct wheel *, struct wheel_elem *, int64_t expires);
+bool wheel_pending (const struct wheel_elem *);
+
+void wheel_advance (struct wheel *, int64_t now,
+		wheel_action_func *, void *aux);
+
+int64_t wheel_next_expiry (struct wheel *);
+
+size_t wheel_size (const struct wheel *);
+bool wheel_empty (const struct wheel *);
+
+#endif /* lib/kernel/wheel.h */
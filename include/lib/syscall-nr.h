@@ -36,6 +36,14 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extensions. */
+	SYS_FUTEX,                  /* Wait on or wake a user memory word. */
+	SYS_THREAD_STATS,           /* Get the caller's CPU accounting. */
 };
 
+/* Operations for SYS_FUTEX. */
+#define FUTEX_WAIT 0            /* Sleep if the word holds a value. */
+#define FUTEX_WAKE 1            /* Wake up to a number of sleepers. */
+
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,24 @@
+#ifndef __LIB_THREAD_STATS_H
+#define __LIB_THREAD_STATS_H
+
+#include <stdint.h>
+
+/* CPU accounting for one thread, in time stamp counter cycles,
+   as returned by the thread_stats() system call. */
+
+/* Number of buckets in the run queue wait histogram. */
+#define THREAD_STATS_BUCKETS 32
+
+struct thread_stats {
+	uint64_t user_cycles;           /* Running in user mode. */
+	uint64_t kernel_cycles;         /* Running in the kernel. */
+	uint64_t voluntary_switches;    /* Gave up the CPU by blocking. */
+	uint64_t involuntary_switches;  /* Preempted or yielded while ready. */
+
+	/* Time from becoming ready to running.  Bucket B counts the
+	   waits of 2**B to 2**(B+1) - 1 cycles; the last bucket also
+	   counts all longer waits. */
+	uint32_t rq_wait_hist[THREAD_STATS_BUCKETS];
+};
+
+#endif /* lib/thread-stats.h */
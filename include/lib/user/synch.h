@@ -0,0 +1,33 @@
+#ifndef __LIB_USER_SYNCH_H
+#define __LIB_USER_SYNCH_H
+
+#include <stdbool.h>
+
+/* Mutex.  Taking and releasing a mutex that nobody else wants
+   costs one atomic instruction each and no system call; only
+   contention goes through futex(). */
+struct mutex {
+	int state;                  /* 0: free, 1: held, 2: held with waiters. */
+};
+
+#define MUTEX_INITIALIZER { 0 }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* Condition variable, used with a mutex like the kernel's
+   struct condition is used with a struct lock. */
+struct condvar {
+	int seq;                    /* Incremented by every signal. */
+};
+
+#define CONDVAR_INITIALIZER { 0 }
+
+void condvar_init (struct condvar *);
+void condvar_wait (struct condvar *, struct mutex *);
+void condvar_signal (struct condvar *);
+void condvar_broadcast (struct condvar *);
+
+#endif /* lib/user/synch.h */
@@ -0,0 +1,95 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Most CPUs that the kernel will bring up. */
+#define CPU_MAX 16
+
+/* Interrupt vectors delivered by the local APIC.  They sit just
+   above the PIC's 0x20...0x2f and, like those, are handled as
+   external interrupts. */
+#define LAPIC_TIMER_VEC 0x30    /* Per-CPU scheduler tick. */
+#define LAPIC_IPI_VEC 0x31      /* Wakes an idle CPU or makes it reschedule. */
+#define LAPIC_SPURIOUS_VEC 0x3f /* Spurious interrupt; never acknowledged. */
+
+/* Per-CPU data.
+
+   Everything here is private to its CPU, and protected by turning
+   interrupts off, except the run queue and `curr', which other
+   CPUs read and change when they wake or steal threads.  Those
+   are protected by rq_lock, which the scheduler holds from before
+   it changes the running thread's status until the switch is
+   complete; see schedule(). */
+struct cpu {
+	int id;                     /* Index in cpus[]. */
+	uint8_t apic_id;            /* Local APIC ID. */
+
+	/* Owned by thread.c. */
+	struct spinlock rq_lock;    /* Protects the run queue and curr. */
+	struct thread *idle_thread; /* Runs when nothing else is ready. */
+	struct thread *curr;        /* Running thread. */
+	unsigned thread_ticks;      /* # of timer ticks since last yield. */
+	int64_t ticks;              /* # of timer ticks on this CPU. */
+	bool wake_batch;            /* In thread_wake(): hold off idle CPU kicks. */
+	struct thread *dying;       /* Exited thread to free after the switch. */
+
+	/* Owned by rcu.c. */
+	int64_t rcu_qs_gp;          /* Last grace period with a quiescent state here. */
+
+	/* Owned by vmalloc.c. */
+	int64_t tlb_gen;            /* Flush generation of the last TLB flush here. */
+
+	/* Run queue of threads in THREAD_READY state.  There is one
+	   FIFO list per priority level, and bit P of ready_bitmap is
+	   set if and only if ready_queues[P] is nonempty, so the
+	   highest ready priority is found with a single `bsr'. */
+	struct list ready_queues[PRI_MAX + 1];
+	uint64_t ready_bitmap;
+
+	/* Run queue of ready threads in the EDF class, earliest
+	   deadline first.  These always run before the threads in
+	   ready_queues, and stay on this CPU.  edf_util is the sum of
+	   runtime / period over the EDF threads admitted here, in
+	   millionths. */
+	struct heap edf_ready;
+	long edf_util;
+
+	/* Number of threads in either run queue, for the MLFQS load
+	   average. */
+	int ready_cnt;
+
+	/* Statistics. */
+	long long idle_ticks;       /* # of timer ticks spent idle. */
+	long long kernel_ticks;     /* # of timer ticks in kernel threads. */
+	long long user_ticks;       /* # of timer ticks in user programs. */
+	long long steal_cnt;        /* # of threads taken from other CPUs. */
+	long long switch_cnt;       /* # of thread switches. */
+
+	/* Owned by interrupt.c. */
+	bool in_external_intr;      /* Processing an external interrupt? */
+	bool yield_on_return;       /* Yield on interrupt return? */
+	uint64_t irqsoff_start;     /* TSC when interrupts went off, or 0. */
+	void *irqsoff_caller;       /* Who turned them off. */
+};
+
+extern struct cpu cpus[CPU_MAX];
+extern int cpu_cnt;
+extern bool cpu_smp;
+extern int smp_cpu_request;
+
+void cpu_init (struct cpu *, int id, uint8_t apic_id);
+struct cpu *cpu_current (void);
+void cpu_kick_idle (void);
+void cpu_resched (struct cpu *);
+
+void smp_init (void);
+void ap_main (void) NO_RETURN;
+
+void lapic_eoi (void);
+
+#endif /* threads/cpu.h */
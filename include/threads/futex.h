@@ -0,0 +1,8 @@
+#ifndef THREADS_FUTEX_H
+#define THREADS_FUTEX_H
+
+void futex_init (void);
+int futex_wait (int *futex, int val);
+int futex_wake (int *futex, int n);
+
+#endif /* threads/futex.h */
@@ -14,6 +14,7 @@ enum intr_level intr_get_level (void);
 enum intr_level intr_set_level (enum intr_level);
 enum intr_level intr_enable (void);
 enum intr_level intr_disable (void);
+void intr_wait (void);
 
 /* Interrupt stack frame. */
 struct gp_registers {
@@ -66,12 +67,20 @@ struct intr_frame {
 typedef void intr_handler_func (struct intr_frame *);
 
 void intr_init (void);
+void intr_init_ap (void);
 void intr_register_ext (uint8_t vec, intr_handler_func *, const char *name);
 void intr_register_int (uint8_t vec, int dpl, enum intr_level,
                         intr_handler_func *, const char *name);
 bool intr_context (void);
 void intr_yield_on_return (void);
 
+void intr_print_stats (void);
+
+/* Trace interrupts-off sections?  Set by the -irqsoff option. */
+extern bool intr_irqsoff_trace;
+void intr_irqsoff_print (void);
+uint64_t intr_irqsoff_max (void);
+void intr_irqsoff_reset (void);
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
 
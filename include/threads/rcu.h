@@ -0,0 +1,92 @@
+#ifndef THREADS_RCU_H
+#define THREADS_RCU_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Read-copy update.
+
+   RCU lets readers of a shared structure run without taking any
+   lock, and without ever being blocked by writers.  A reader
+   brackets its accesses with rcu_read_lock() and
+   rcu_read_unlock().  A writer, which must still exclude other
+   writers by some other means, changes the structure so that
+   each reader sees either the old version or the new one, for
+   example with list_remove_rcu(), and then must not free the old
+   version until every reader that might still be looking at it
+   is done.  It does that by waiting for a "grace period" with
+   synchronize_rcu(), or by handing the freeing to call_rcu(),
+   which runs it after a grace period without making the writer
+   wait.
+
+   Read-side critical sections may nest, and the thread in one
+   may be preempted, but it must not sleep.  See rcu.c for how
+   grace periods are detected. */
+
+/* Callback for call_rcu().  HEAD is the rcu_head passed to it,
+   normally embedded in the structure to be freed. */
+struct rcu_head;
+typedef void rcu_func (struct rcu_head *head);
+
+/* Deferred call.  Embed one in each structure that may be freed
+   with call_rcu(). */
+struct rcu_head {
+	struct rcu_head *next;      /* Next callback. */
+	rcu_func *func;             /* Function to call. */
+	int64_t gp;                 /* Grace period it waits for. */
+};
+
+/* Converts pointer to rcu_head RCU_HEAD into a pointer to the
+   structure that RCU_HEAD is embedded inside.  Supply the name
+   of the outer structure STRUCT and the member name MEMBER of
+   the rcu_head. */
+#define rcu_entry(RCU_HEAD, STRUCT, MEMBER)                     \
+	((STRUCT *) ((uint8_t *) &(RCU_HEAD)->next              \
+		- offsetof (STRUCT, MEMBER.next)))
+
+/* Number of grace periods started.  Only rcu.c modifies it. */
+extern volatile int64_t rcu_gp_seq;
+
+void rcu_init (void);
+
+void call_rcu (struct rcu_head *, rcu_func *);
+void synchronize_rcu (void);
+
+void rcu_note_switch (struct thread *);
+void rcu_tick (void);
+void rcu_quiescent_state (void);
+void rcu_read_unlock_special (void);
+
+/* Begins an RCU read-side critical section.  Takes no lock and
+   does not turn off interrupts. */
+static inline void
+rcu_read_lock (void) {
+	struct thread *t = thread_current ();
+
+	if (t->rcu_nesting++ == 0)
+		t->rcu_read_gp = rcu_gp_seq;
+	barrier ();
+}
+
+/* Ends an RCU read-side critical section. */
+static inline void
+rcu_read_unlock (void) {
+	struct thread *t = thread_current ();
+
+	barrier ();
+	ASSERT (t->rcu_nesting > 0);
+	if (--t->rcu_nesting == 0 && t->rcu_blocked)
+		rcu_read_unlock_special ();
+}
+
+/* Returns true if the running thread is in an RCU read-side
+   critical section. */
+static inline bool
+rcu_read_lock_held (void) {
+	return thread_current ()->rcu_nesting > 0;
+}
+
+#endif /* threads/rcu.h */
@@ -0,0 +1,42 @@
+#ifndef THREADS_SCHEDTRACE_H
+#define THREADS_SCHEDTRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/thread.h"
+
+/* Scheduler event trace.
+
+   When enabled with the -sched-trace option, the scheduler
+   records every state change of every thread, with a TSC
+   timestamp, in a fixed-size ring buffer.  The ring is dumped to
+   the console as CSV at shutdown, or on demand with
+   sched_trace_dump(), and utils/sched-trace turns the dump into
+   per-thread timelines and run-queue wait histograms. */
+
+/* Why an event was recorded. */
+enum sched_trace_reason {
+	ST_SWITCH_OUT,              /* Stopped running, in schedule(). */
+	ST_SWITCH_IN,               /* Started running, in schedule(). */
+	ST_BLOCK,                   /* Called thread_block(). */
+	ST_UNBLOCK,                 /* Put in a run queue by thread_unblock(). */
+	ST_WAKE,                    /* Sleep timer expired. */
+	ST_PRIORITY                 /* Effective priority changed. */
+};
+
+extern bool sched_trace_enabled;
+
+void sched_trace_record (const struct thread *, enum thread_status old,
+		enum thread_status new, enum sched_trace_reason);
+void sched_trace_dump (void);
+
+/* Records an event for thread T, if tracing is enabled.
+   Interrupts must be off. */
+static inline void
+sched_trace (const struct thread *t, enum thread_status old,
+		enum thread_status new, enum sched_trace_reason reason) {
+	if (sched_trace_enabled)
+		sched_trace_record (t, old, new, reason);
+}
+
+#endif /* threads/schedtrace.h */
@@ -0,0 +1,29 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object caches.
+
+   A cache hands out objects of one size, carved from pages
+   ("slabs") obtained from the page allocator, so unlike
+   malloc(), which rounds every request up to a power of 2, it
+   wastes no space on rounding.  If the cache has a constructor,
+   each object is constructed once, when its slab is created,
+   and must be back in its constructed state whenever it is
+   freed, so that allocating it again costs nothing more.  See
+   slab.c for details. */
+
+/* Puts the object at OBJ into its constructed state. */
+typedef void kmem_ctor (void *obj);
+
+struct kmem_cache;
+
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		size_t align, kmem_ctor *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+
+void kmem_print_stats (void);
+
+#endif /* threads/slab.h */
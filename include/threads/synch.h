@@ -1,13 +1,30 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+
+struct thread;
+
+/* Wait queue: threads waiting for an event, by priority. */
+struct waitq {
+	struct heap threads;        /* Threads, by priority then arrival. */
+};
+
+void waitq_init (struct waitq *);
+void waitq_push (struct waitq *, struct thread *);
+struct thread *waitq_pop (struct waitq *);
+struct thread *waitq_max (const struct waitq *);
+void waitq_update (struct thread *);
+bool waitq_empty (const struct waitq *);
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct waitq waiters;       /* Waiting threads. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -16,21 +33,51 @@ bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
+/* Contention statistics for a class of locks: all the locks
+   and spin locks given the same name by lock_set_name() or
+   spin_set_name(), or else all the unnamed locks initialized at
+   the same call site.  Only kept
+   with the -lockstat option.  Times are in TSC cycles. */
+struct lock_stat {
+	const char *name;           /* Name, or NULL. */
+	void *site;                 /* Caller of lock_init(), if unnamed. */
+	long long acquired_cnt;     /* Number of acquisitions. */
+	long long contended_cnt;    /* Number that had to wait. */
+	long long donation_cnt;     /* Number of priority donations. */
+	uint64_t wait_total;        /* Time spent waiting. */
+	uint64_t wait_max;
+	uint64_t hold_total;        /* Time held. */
+	uint64_t hold_max;
+};
+
 /* Lock. */
 struct lock {
-	struct thread *holder;      /* Thread holding lock (for debugging). */
-	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct thread *holder;      /* Thread holding lock, or NULL if free. */
+	bool contended;             /* Has anyone had to wait? */
+	struct waitq waiters;       /* Waiting threads. */
+	int priority;               /* Priority of greatest waiter. */
+	struct thread *donee;       /* Thread whose held_locks has this lock. */
+	struct heap_elem held_elem; /* Element in donee's held_locks. */
+	struct lock_stat *stat;     /* Statistics, or NULL if not kept. */
+	uint64_t acquire_tsc;       /* When the holder acquired it. */
 };
 
+extern bool lockstat_enabled;
+
 void lock_init (struct lock *);
+void lock_set_name (struct lock *, const char *name);
+void lock_print_stats (void);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+int lock_donated_priority (struct thread *);
+bool lock_priority_less (const struct heap_elem *, const struct heap_elem *,
+		void *aux);
 
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct waitq waiters;       /* Waiting threads. */
 };
 
 void cond_init (struct condition *);
@@ -38,6 +85,62 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Most reader-writer locks that one thread may hold at once. */
+#define RW_HOLD_MAX 8
+
+/* Reader-writer lock. */
+struct rwlock {
+	struct thread *writer;      /* Thread holding write lock, or NULL. */
+	int reader_cnt;             /* Number of threads holding read lock. */
+	struct list holders;        /* struct rw_hold of every holder. */
+	struct waitq readers;       /* Threads waiting to read. */
+	struct waitq writers;       /* Threads waiting to write. */
+	struct thread *upgrader;    /* Reader waiting to upgrade, or NULL. */
+};
+
+/* One thread's hold on a reader-writer lock.  Each thread has
+   RW_HOLD_MAX of them, so that a lock can find all its readers
+   and a thread can find all the locks it holds. */
+struct rw_hold {
+	struct list_elem elem;      /* Element in rwlock's holders. */
+	struct rwlock *rw;          /* Lock held, or NULL if unused. */
+	struct thread *thread;      /* Holding thread. */
+};
+
+void rw_init (struct rwlock *);
+void rw_read_acquire (struct rwlock *);
+void rw_read_release (struct rwlock *);
+void rw_write_acquire (struct rwlock *);
+void rw_write_release (struct rwlock *);
+bool rw_upgrade (struct rwlock *);
+void rw_downgrade (struct rwlock *);
+bool rw_held_by_current_thread (const struct rwlock *);
+
+/* Spin lock.  Busy-waits instead of sleeping, so it can protect
+   data shared between CPUs in places that cannot sleep, such as
+   interrupt handlers and the scheduler itself.  A spin lock must
+   only be held with interrupts off, and only briefly. */
+struct spinlock {
+	volatile int locked;        /* Nonzero while held. */
+	struct cpu *cpu;            /* CPU holding lock (for debugging). */
+	struct lock_stat *stat;     /* Statistics, or NULL if not kept. */
+	uint64_t acquire_tsc;       /* When the holder acquired it. */
+};
+
+void spin_init (struct spinlock *);
+void spin_set_name (struct spinlock *, const char *name);
+void spin_lock (struct spinlock *);
+bool spin_try_lock (struct spinlock *);
+void spin_unlock (struct spinlock *);
+bool spin_held_by_current_cpu (const struct spinlock *);
+
+/* Protects wait queues, semaphores, condition variables,
+   reader-writer locks and priority donation.  See synch.c. */
+extern struct spinlock synch_lock;
+
+enum intr_level synch_enter (void);
+void synch_exit (enum intr_level);
+
 
 
 /* Optimization barrier.
@@ -4,7 +4,11 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include <thread-stats.h>
+#include <wheel.h>
+#include "threads/fixed-point.h"
 #include "threads/interrupt.h"
+#include "threads/synch.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -32,6 +36,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. - 기본 우선 순위 */
 #define PRI_MAX 63                      /* Highest priority. - 높은 우선 순위 */
 
+/* Thread niceness, for the MLFQS scheduler. */
+#define NICE_MIN -20                    /* Nicest to other threads. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
 /* A kernel thread or user process.
  * 커널 스레드 또는 사용자 프로세스
  *
@@ -124,7 +133,36 @@ struct thread {
 	enum thread_status status;          /* Thread state. - 스레드 상태 */
 	char name[16];                      /* Name (for debugging purposes). - 이름 (디버깅 목적으로) */
 	int priority;                       /* Priority. - 우선순위 1~63 */
-	int64_t wake_tick;					// 일어나야 할 시간
+	struct wheel_elem sleep_elem;       /* Sleep timer, expires at the wake tick. - 일어나야 할 시간 */
+	int64_t sleep_deadline;             /* Latest tick to wake up at. */
+	bool sleep_slack;                   /* Past its wake tick, waiting for company? */
+	struct cpu *cpu;                    /* CPU running it, or whose run queue it was last put on. */
+
+	/* Earliest-deadline-first reservation, in timer ticks.  See
+	   thread_set_edf(). */
+	bool edf;                           /* In the EDF class? */
+	bool edf_throttled;                 /* Out of budget, must wait for the next period. */
+	int64_t edf_runtime;                /* Budget per period. */
+	int64_t edf_period;                 /* Period length. */
+	int64_t edf_rel_deadline;           /* Deadline, relative to the period's start. */
+	int64_t edf_period_start;           /* Start of the current period. */
+	int64_t edf_deadline;               /* Absolute deadline of the current period. */
+	int64_t edf_budget;                 /* Budget left in the current period. */
+	int64_t edf_jobs, edf_misses;       /* Jobs finished, and finished late. */
+	struct heap_elem edf_elem;          /* Element in the CPU's EDF run queue. */
+
+	/* Multi-level feedback queue scheduler state.  See
+	   mlfqs_catch_up(). */
+	int nice;                           /* Niceness. */
+	fixed_t recent_cpu;                 /* Recent CPU time, in ticks. */
+	int64_t mlfqs_stamp;                /* Decays of recent_cpu applied so far. */
+	bool mlfqs_fixed;                   /* Created at PRI_MAX: keeps it. */
+
+	/* Read-copy update.  See rcu.c. */
+	int rcu_nesting;                    /* Depth of RCU read-side critical sections. */
+	int64_t rcu_read_gp;                /* rcu_gp_seq when the outermost one began. */
+	bool rcu_blocked;                   /* Preempted in one, holding up grace periods? */
+	struct list_elem rcu_elem;          /* Element in list of blocked readers. */
 
 	/* Shared between thread.c and synch.c. - thread.c와 synch.c 간에 공유됩니다. */
 	struct list_elem elem;              /* List element. - 리스트 요소 */
@@ -132,8 +170,12 @@ struct thread {
 	// 수정!!!!
 	int init_priority;		// 수정!!!, 양도 받았다가 원래의 값으로 돌아가기 위한 값
 	struct lock *wait_on_lock;	// 스레드가 현재 얻기 위해 기다리는 lock
-	struct list donations;		// 현재 thread에게 priority를 나눠준 쓰레드 리스트
-	struct list_elem donation_elem; // donations 리스트를 관리하기 위한 elem
+	struct heap held_locks;		// 가진 lock 중 waiter가 있는 lock들, waiter의 priority 순
+	struct waitq *waitq;            /* Wait queue it is in, or NULL. */
+	struct heap_elem wait_elem;     /* Element in waitq. */
+	unsigned wait_seq;              /* Arrival order within waitq. */
+	struct rwlock *wait_on_rwlock;  /* Reader-writer lock being waited for. */
+	struct rw_hold rw_holds[RW_HOLD_MAX]; /* Reader-writer locks held. */
 	
 
 #ifdef USERPROG
@@ -147,6 +189,10 @@ struct thread {
 
 	/* Owned by thread.c. - 스레드가 소유 */
 	struct intr_frame tf;               /* Information for switching - switching을 위한 정보 */
+	uint64_t switch_rsp;                /* Stack pointer saved by switch_context(), or 0 to resume from tf. */
+	uint64_t acct_tsc;                  /* TSC at the start of the current accounting interval. */
+	uint64_t ready_tsc;                 /* TSC when it last became ready, or 0. */
+	struct thread_stats stats;          /* CPU accounting. */
 	unsigned magic;                     /* Detects stack overflow. - 스택 오버플로를 탐지 */
 };
 
@@ -160,16 +206,40 @@ struct thread {
 
 extern bool thread_mlfqs;
 
+/* If true, switch threads by saving and restoring a whole
+   `struct intr_frame' through iretq, as Pintos originally did,
+   instead of with switch_context().  For benchmarking only. */
+extern bool thread_switch_iret;
+
+/* If true, allocate every thread a fresh, zeroed page instead of
+   reusing the pages of dead threads.  For benchmarking only. */
+extern bool thread_cache_disabled;
+
+/* If true, print each thread's CPU accounting when it exits.
+   Controlled by kernel command-line option "-thread-stats". */
+extern bool thread_stats_on_exit;
+
 void thread_init (void);
 void thread_start (void);
 
+struct cpu;
+struct thread *thread_alloc_ap (struct cpu *);
+void thread_init_ap (void);
+void thread_start_ap (void) NO_RETURN;
+
 void thread_tick (void);
 void thread_print_stats (void);
+long long thread_switch_cnt (void);
+long long thread_wake_pass_cnt (void);
+void thread_acct_enter_kernel (void);
+void thread_acct_exit_kernel (void);
+void thread_get_stats (struct thread_stats *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
 
 void thread_block (void);
+void thread_block_locked (struct spinlock *guard);
 void thread_unblock (struct thread *);
 
 struct thread *thread_current (void);
@@ -189,18 +259,21 @@ int thread_get_load_avg (void);
 
 void do_iret (struct intr_frame *tf);
 
-bool cmp(struct list_elem *state_a, struct list_elem *state_b, void *aux UNUSED);
+bool thread_set_edf (int64_t runtime, int64_t period, int64_t deadline);
+void thread_clear_edf (void);
+void thread_edf_yield (void);
+void thread_get_edf_stats (int64_t *jobs, int64_t *misses);
+heap_less_func thread_deadline_less;
+
+void thread_sleep (int64_t wake_tick);
+void thread_sleep_range (int64_t earliest, int64_t latest);
+void thread_wake (int64_t tick);
+
 bool cmp_thread_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
 void preempt_priority(void);
+void thread_set_effective_priority (struct thread *, int priority);
 void donate_priority(void);
-void update_priority_before_donations(void);
-
-bool cmp_donation_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
-void donate_priority(void);
-void remove_donor(struct lock *lock);
-void update_priority_before_donations(void);
-
+void update_priority_for_donations(void);
 
-bool cmp_sema_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
 
 #endif /* threads/thread.h */
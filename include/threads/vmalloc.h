@@ -0,0 +1,41 @@
+#ifndef THREADS_VMALLOC_H
+#define THREADS_VMALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Virtually contiguous kernel memory.
+
+   vmalloc() builds a block out of pages that need not be
+   physically contiguous, and maps them at consecutive addresses
+   in a range of kernel virtual memory reserved for it, so large
+   blocks can still be had when the page pools are fragmented.
+   Memory from vmalloc() has no physical address that vtop() can
+   compute, so it must not be handed to hardware.  See
+   vmalloc.c for details.
+
+   malloc() does not use vmalloc().  Code that keeps a table that
+   can grow past a page, such as the free map or a hash table's
+   buckets, asks for it with kvmalloc() instead. */
+
+/* The reserved range.  It lies in the same 512 GB slot of the
+   page map level 4 as the kernel's mapping of physical memory,
+   so every pml4 copied from base_pml4 sees it. */
+#define VMALLOC_START 0xc000000000
+#define VMALLOC_PAGES 65536         /* 256 MB. */
+#define VMALLOC_END (VMALLOC_START + (uint64_t) VMALLOC_PAGES * 4096)
+
+/* Returns true if VADDR is in the vmalloc() range. */
+#define is_vmalloc_vaddr(vaddr) \
+	((uint64_t) (vaddr) >= VMALLOC_START && (uint64_t) (vaddr) < VMALLOC_END)
+
+void vmalloc_init (void);
+void *vmalloc (size_t size) __attribute__ ((malloc));
+void vfree (void *);
+void *kvmalloc (size_t size) __attribute__ ((malloc));
+void *kvcalloc (size_t a, size_t b) __attribute__ ((malloc));
+void kvfree (void *);
+void vmalloc_tick (void);
+
+#endif /* threads/vmalloc.h */
@@ -0,0 +1,41 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <wheel.h>
+
+/* Deferred work.
+
+   An interrupt handler runs with interrupts off, so everything
+   it does adds to the interrupt latency of the whole system.  A
+   handler should only do what cannot wait, such as
+   acknowledging the device, and hand the rest to queue_work().
+   The work then runs soon after, in a kernel worker thread, with
+   interrupts on, and may sleep. */
+
+/* A function to run as deferred work, given auxiliary data AUX. */
+typedef void work_func (void *aux);
+
+/* A piece of deferred work.  The owner embeds one for each job
+   it defers, and may queue it again once it has started. */
+struct work {
+	struct list_elem elem;      /* Element in the pending list. */
+	struct wheel_elem timer;    /* Delay, for queue_delayed_work(). */
+	work_func *func;            /* Function to run. */
+	void *aux;                  /* Its argument. */
+	bool pending;               /* Queued or delayed, not yet started? */
+};
+
+void workqueue_init (void);
+void workqueue_start (void);
+
+void work_init (struct work *, work_func *, void *aux);
+bool queue_work (struct work *);
+bool queue_delayed_work (struct work *, int64_t ticks);
+
+void workqueue_tick (int64_t now);
+int64_t workqueue_next_expiry (void);
+
+#endif /* threads/workqueue.h */
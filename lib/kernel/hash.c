@@ -7,7 +7,7 @@
 
 #include "hash.h"
 #include "../debug.h"
-#include "threads/malloc.h"
+#include "threads/vmalloc.h"
 
 #define list_elem_to_hash_elem(LIST_ELEM)                       \
 	list_entry(LIST_ELEM, struct hash_elem, list_elem)
@@ -26,7 +26,7 @@ hash_init (struct hash *h,
 		hash_hash_func *hash, hash_less_func *less, void *aux) {
 	h->elem_cnt = 0;
 	h->bucket_cnt = 4;
-	h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
+	h->buckets = kvmalloc (sizeof *h->buckets * h->bucket_cnt);
 	h->hash = hash;
 	h->less = less;
 	h->aux = aux;
@@ -81,7 +81,7 @@ void
 hash_destroy (struct hash *h, hash_action_func *destructor) {
 	if (destructor != NULL)
 		hash_clear (h, destructor);
-	free (h->buckets);
+	kvfree (h->buckets);
 }
 
 /* Inserts NEW into hash table H and returns a null pointer, if
@@ -344,8 +344,10 @@ rehash (struct hash *h) {
 	if (new_bucket_cnt == old_bucket_cnt)
 		return;
 
-	/* Allocate new buckets and initialize them as empty. */
-	new_buckets = malloc (sizeof *new_buckets * new_bucket_cnt);
+	/* Allocate new buckets and initialize them as empty.  A big
+	   table's buckets come from vmalloc(), since they need not be
+	   physically contiguous. */
+	new_buckets = kvmalloc (sizeof *new_buckets * new_bucket_cnt);
 	if (new_buckets == NULL) {
 		/* Allocation failed.  This means that use of the hash table will
 		   be less efficient.  However, it is still usable, so
@@ -375,7 +377,7 @@ rehash (struct hash *h) {
 		}
 	}
 
-	free (old_buckets);
+	kvfree (old_buckets);
 }
 
 /* Inserts E into BUCKET (in hash table H). */
@@ -0,0 +1,170 @@
+/* Pairing heap.
+
+   See heap.h for basic information.  The algorithm is the
+   two-pass pairing heap of Fredman, Sedgewick, Sleator and
+   Tarjan, "The pairing heap: a new form of self-adjusting heap",
+   Algorithmica 1 (1986).  Each element keeps its children in a
+   doubly-linked list whose first element points back to the
+   parent, so that any element can be cut out in O(1). */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *meld (struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+static void cut (struct heap_elem *);
+
+/* Initializes H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->elem_cnt = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into H.  E must not already be in a heap. */
+void
+heap_insert (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->prev = e->next = e->child = NULL;
+	h->root = h->root != NULL ? meld (h, h->root, e) : e;
+	h->elem_cnt++;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	struct heap_elem *children;
+
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+	ASSERT (h->elem_cnt > 0);
+
+	children = merge_pairs (h, e->child);
+	if (e == h->root)
+		h->root = children;
+	else {
+		cut (e);
+		if (children != NULL)
+			h->root = meld (h, h->root, children);
+	}
+	e->prev = e->next = e->child = NULL;
+	h->elem_cnt--;
+}
+
+/* Restores H's ordering after the key of E, which must be in H,
+   has changed. */
+void
+heap_update (struct heap *h, struct heap_elem *e) {
+	heap_remove (h, e);
+	heap_insert (h, e);
+}
+
+/* Returns the greatest element in H, or a null pointer if H is
+   empty.  If several elements are equally great, which one is
+   returned is unspecified. */
+struct heap_elem *
+heap_max (const struct heap *h) {
+	ASSERT (h != NULL);
+	return h->root;
+}
+
+/* Removes and returns the greatest element in H, which must not
+   be empty. */
+struct heap_elem *
+heap_pop_max (struct heap *h) {
+	struct heap_elem *max = heap_max (h);
+
+	ASSERT (max != NULL);
+	heap_remove (h, max);
+	return max;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h) {
+	return h->elem_cnt;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+heap_empty (const struct heap *h) {
+	return h->root == NULL;
+}
+
+/* Combines the trees rooted at A and B, neither of which may
+   have siblings, into one, and returns its root. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (h->less (a, b, h->aux)) {
+		struct heap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	/* Make B the first child of A. */
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Combines the sibling trees starting at FIRST into one, and
+   returns its root, or a null pointer if FIRST is null.  Melds
+   them in pairs from left to right, then melds the pairs from
+   right to left, which is what makes removal O(log n) amortized. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	/* First pass.  PAIRS is a stack, linked through `next', so
+	   that the second pass visits the pairs in reverse. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+
+		a->prev = a->next = NULL;
+		if (b != NULL) {
+			first = b->next;
+			b->prev = b->next = NULL;
+			a = meld (h, a, b);
+		} else
+			first = NULL;
+		a->next = pairs;
+		pairs = a;
+	}
+
+	/* Second pass. */
+	while (pairs != NULL) {
+		struct heap_elem *a = pairs;
+
+		pairs = a->next;
+		a->next = NULL;
+		root = root != NULL ? meld (h, root, a) : a;
+	}
+	return root;
+}
+
+/* Removes non-root element E, together with its subtree, from
+   the list of its parent's children. */
+static void
+cut (struct heap_elem *e) {
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	e->prev = e->next = NULL;
+}
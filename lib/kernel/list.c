@@ -318,6 +318,90 @@ list_reverse (struct list *list) {
 	}
 }
 
+/* Lists read under RCU.
+
+   Readers only ever follow `next' links, so writers keep every
+   `next' link that a reader might be standing on valid: a new
+   element is filled in completely before the link that makes it
+   reachable is stored, and a removed element keeps its own
+   `next' link, so that a reader on it can still reach the rest
+   of the list.  x86 does not reorder stores with other stores,
+   or loads with other loads, so only the compiler needs to be
+   kept from reordering, and the pointer loads and stores that
+   readers race with are made through volatile pointers so that
+   each happens exactly once. */
+
+/* Optimization barrier. */
+#define rcu_barrier() asm volatile ("" : : : "memory")
+
+/* Stores ELEM into *LINK, in a single store that a concurrent
+   reader sees either before or after. */
+static inline void
+rcu_assign (struct list_elem **link, struct list_elem *elem) {
+	rcu_barrier ();
+	*(struct list_elem *volatile *) link = elem;
+}
+
+/* Loads *LINK in a single load that is not repeated. */
+static inline struct list_elem *
+rcu_deref (struct list_elem **link) {
+	struct list_elem *elem = *(struct list_elem *volatile *) link;
+	rcu_barrier ();
+	return elem;
+}
+
+/* Returns the beginning of LIST, for a reader. */
+struct list_elem *
+list_begin_rcu (struct list *list) {
+	ASSERT (list != NULL);
+	return rcu_deref (&list->head.next);
+}
+
+/* Returns the element after ELEM in its list, for a reader.
+   ELEM may have been removed with list_remove_rcu() since the
+   reader reached it. */
+struct list_elem *
+list_next_rcu (struct list_elem *elem) {
+	ASSERT (elem != NULL);
+	return rcu_deref (&elem->next);
+}
+
+/* Inserts ELEM just before BEFORE, which may be either an
+   interior element or a tail, so that readers see either the
+   list without ELEM or the list with it. */
+void
+list_insert_rcu (struct list_elem *before, struct list_elem *elem) {
+	ASSERT (is_interior (before) || is_tail (before));
+	ASSERT (elem != NULL);
+
+	elem->prev = before->prev;
+	elem->next = before;
+	rcu_assign (&before->prev->next, elem);
+	before->prev = elem;
+}
+
+/* Inserts ELEM at the beginning of LIST, for readers. */
+void
+list_push_front_rcu (struct list *list, struct list_elem *elem) {
+	list_insert_rcu (list_begin (list), elem);
+}
+
+/* Inserts ELEM at the end of LIST, for readers. */
+void
+list_push_back_rcu (struct list *list, struct list_elem *elem) {
+	list_insert_rcu (list_end (list), elem);
+}
+
+/* Removes ELEM from its list.  Readers that have already reached
+   ELEM may go on from it, so ELEM must not be freed or reused
+   until a grace period has passed. */
+void
+list_remove_rcu (struct list_elem *elem) {
+	ASSERT (is_interior (elem));
+	rcu_assign (&elem->prev->next, elem->next);
+	elem->next->prev = elem->prev;
+}
+
 /* Returns true only if the list elements A through B (exclusive)
    are in order according to LESS given auxiliary data AUX. */
 static bool
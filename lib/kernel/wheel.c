@@ -0,0 +1,204 @@
+/* Hierarchical timing wheel.
+
+   See wheel.h for basic information. */
+
+#include "wheel.h"
+#include "../debug.h"
+
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+
+/* Largest expiry distance, in ticks, that the wheel can
+   represent directly. */
+#define WHEEL_MAX_DELTA ((1LL << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+#define list_elem_to_wheel_elem(LIST_ELEM)                      \
+	list_entry(LIST_ELEM, struct wheel_elem, list_elem)
+
+static struct list *find_slot (struct wheel *, int64_t expires);
+static void take_slot (struct list *slot, struct list *dst);
+static int cascade (struct wheel *, int level);
+
+/* Initializes wheel W to be empty, with NOW as the first tick
+   that wheel_advance() will process. */
+void
+wheel_init (struct wheel *w, int64_t now) {
+	int level, i;
+
+	w->base = now;
+	w->elem_cnt = 0;
+	for (level = 0; level < WHEEL_LEVELS; level++)
+		for (i = 0; i < WHEEL_SIZE; i++)
+			list_init (&w->slots[level][i]);
+}
+
+/* Initializes E as not being in any wheel. */
+void
+wheel_elem_init (struct wheel_elem *e) {
+	e->list_elem.prev = e->list_elem.next = NULL;
+	e->expires = 0;
+}
+
+/* Inserts E into W so that it expires at tick EXPIRES.  E must
+   not already be in a wheel.  If EXPIRES has already passed, E
+   expires on the next call to wheel_advance(). */
+void
+wheel_insert (struct wheel *w, struct wheel_elem *e, int64_t expires) {
+	ASSERT (w != NULL);
+	ASSERT (!wheel_pending (e));
+
+	e->expires = expires;
+	list_push_back (find_slot (w, expires), &e->list_elem);
+	w->elem_cnt++;
+}
+
+/* Removes E, which must be pending, from W. */
+void
+wheel_remove (struct wheel *w, struct wheel_elem *e) {
+	ASSERT (w != NULL);
+	ASSERT (wheel_pending (e));
+
+	list_remove (&e->list_elem);
+	e->list_elem.prev = e->list_elem.next = NULL;
+	w->elem_cnt--;
+}
+
+/* Moves E to expire at tick EXPIRES instead, inserting it into W
+   if it is not already pending. */
+void
+wheel_rearm (struct wheel *w, struct wheel_elem *e, int64_t expires) {
+	if (wheel_pending (e))
+		wheel_remove (w, e);
+	wheel_insert (w, e, expires);
+}
+
+/* Returns true if E is currently in a wheel. */
+bool
+wheel_pending (const struct wheel_elem *e) {
+	ASSERT (e != NULL);
+	return e->list_elem.next != NULL;
+}
+
+/* Processes every tick of W up to and including NOW, removing
+   each element whose expiry time has been reached and calling
+   ACTION on it, given auxiliary data AUX.  The order in which
+   elements that expire on the same tick are handed to ACTION is
+   unspecified. */
+void
+wheel_advance (struct wheel *w, int64_t now,
+		wheel_action_func *action, void *aux) {
+	ASSERT (w != NULL);
+	ASSERT (action != NULL);
+
+	while (w->base <= now) {
+		int index = w->base & WHEEL_MASK;
+		struct list expired;
+
+		/* Nothing pending: skip straight to NOW. */
+		if (w->elem_cnt == 0) {
+			w->base = now + 1;
+			break;
+		}
+
+		/* Refill level 0 from the upper levels each time its
+		   index wraps around. */
+		if (index == 0) {
+			int level;
+
+			for (level = 1; level < WHEEL_LEVELS; level++)
+				if (cascade (w, level) != 0)
+					break;
+		}
+
+		take_slot (&w->slots[0][index], &expired);
+		w->base++;
+
+		while (!list_empty (&expired)) {
+			struct wheel_elem *e =
+				list_elem_to_wheel_elem (list_pop_front (&expired));
+
+			e->list_elem.prev = e->list_elem.next = NULL;
+			w->elem_cnt--;
+			action (e, aux);
+		}
+	}
+}
+
+/* Returns a lower bound on the expiry time of the earliest
+   pending element of W, or INT64_MAX if W is empty.  The bound is
+   exact if some element expires within the next WHEEL_SIZE ticks;
+   otherwise it is the next tick at which level 0 is refilled. */
+int64_t
+wheel_next_expiry (struct wheel *w) {
+	int i;
+
+	if (w->elem_cnt == 0)
+		return INT64_MAX;
+
+	for (i = 0; i < WHEEL_SIZE; i++)
+		if (!list_empty (&w->slots[0][(w->base + i) & WHEEL_MASK]))
+			return w->base + i;
+	return (w->base + WHEEL_MASK) & ~(int64_t) WHEEL_MASK;
+}
+
+/* Returns the number of elements pending in W. */
+size_t
+wheel_size (const struct wheel *w) {
+	return w->elem_cnt;
+}
+
+/* Returns true if W has no pending elements, false otherwise. */
+bool
+wheel_empty (const struct wheel *w) {
+	return w->elem_cnt == 0;
+}
+
+/* Returns the slot of W that an element expiring at EXPIRES
+   belongs in. */
+static struct list *
+find_slot (struct wheel *w, int64_t expires) {
+	int64_t delta = expires - w->base;
+	int level;
+
+	/* Already due: put it in the slot that will be processed
+	   next. */
+	if (delta < 0)
+		return &w->slots[0][w->base & WHEEL_MASK];
+
+	/* Too far out: park it as far out as we can.  It will be
+	   re-inserted when its slot cascades. */
+	if (delta > WHEEL_MAX_DELTA) {
+		delta = WHEEL_MAX_DELTA;
+		expires = w->base + delta;
+	}
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (delta < 1LL << (WHEEL_BITS * (level + 1)))
+			break;
+	return &w->slots[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK];
+}
+
+/* Moves every element of SLOT onto DST, which is initialized
+   first, leaving SLOT empty. */
+static void
+take_slot (struct list *slot, struct list *dst) {
+	list_init (dst);
+	if (!list_empty (slot))
+		list_splice (list_end (dst), list_begin (slot), list_end (slot));
+}
+
+/* Re-inserts the elements of the current slot of LEVEL in W
+   into lower levels, and returns that slot's index. */
+static int
+cascade (struct wheel *w, int level) {
+	int index = (w->base >> (WHEEL_BITS * level)) & WHEEL_MASK;
+	struct list elems;
+
+	/* Detach the slot first: an element may map back into the
+	   same slot, and must not be visited twice. */
+	take_slot (&w->slots[level][index], &elems);
+	while (!list_empty (&elems)) {
+		struct wheel_elem *e = list_elem_to_wheel_elem (list_pop_front (&elems));
+		list_push_back (find_slot (w, e->expires), &e->list_elem);
+	}
+	return index;
+}
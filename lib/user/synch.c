@@ -0,0 +1,116 @@
+#include <synch.h>
+#include <limits.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+
+/* User-level mutexes and condition variables built on futex().
+
+   The mutex follows "mutex 2" of Ulrich Drepper, "Futexes Are
+   Tricky": its state is 0 when free, 1 when held, and 2 when held
+   and some thread may be sleeping on it, so that an unlock only
+   has to enter the kernel in the last case. */
+
+/* Atomically sets *P to NEW if it equals OLD.  Returns the value
+   *P had before.  See [IA32-v2a] "CMPXCHG". */
+static inline int
+cmpxchg (int *p, int old, int new) {
+	int prev;
+
+	asm volatile ("lock cmpxchgl %2, %1"
+			: "=a" (prev), "+m" (*p)
+			: "r" (new), "0" (old)
+			: "memory", "cc");
+	return prev;
+}
+
+/* Atomically sets *P to NEW and returns the value it had
+   before.  See [IA32-v2b] "XCHG". */
+static inline int
+xchg (int *p, int new) {
+	asm volatile ("xchgl %0, %1" : "+r" (new), "+m" (*p) : : "memory");
+	return new;
+}
+
+/* Atomically increments *P.  See [IA32-v2a] "INC". */
+static inline void
+atomic_inc (int *p) {
+	asm volatile ("lock incl %0" : "+m" (*p) : : "memory", "cc");
+}
+
+/* Initializes mutex M as free. */
+void
+mutex_init (struct mutex *m) {
+	m->state = 0;
+}
+
+/* Acquires M, sleeping until it is free if necessary.  M must
+   not already be held by the caller. */
+void
+mutex_lock (struct mutex *m) {
+	int state = cmpxchg (&m->state, 0, 1);
+
+	if (state == 0)
+		return;
+
+	/* Contended: mark M as having waiters, and sleep until we are
+	   the ones to take it from free, still marked, since others
+	   may be sleeping too. */
+	if (state != 2)
+		state = xchg (&m->state, 2);
+	while (state != 0) {
+		futex (&m->state, FUTEX_WAIT, 2);
+		state = xchg (&m->state, 2);
+	}
+}
+
+/* Tries to acquire M without sleeping.  Returns true if
+   successful, false if M is held. */
+bool
+mutex_trylock (struct mutex *m) {
+	return cmpxchg (&m->state, 0, 1) == 0;
+}
+
+/* Releases M, which the caller must hold. */
+void
+mutex_unlock (struct mutex *m) {
+	if (xchg (&m->state, 0) == 2)
+		futex (&m->state, FUTEX_WAKE, 1);
+}
+
+/* Initializes condition variable CV. */
+void
+condvar_init (struct condvar *cv) {
+	cv->seq = 0;
+}
+
+/* Atomically releases M and waits for CV to be signaled, then
+   reacquires M.  M must be held.  As with the kernel's condition
+   variables, the caller must recheck its condition afterward. */
+void
+condvar_wait (struct condvar *cv, struct mutex *m) {
+	int seq = cv->seq;
+
+	/* A signal between the unlock and the futex() call bumps SEQ,
+	   so futex() returns at once instead of missing it. */
+	mutex_unlock (m);
+	futex (&cv->seq, FUTEX_WAIT, seq);
+
+	/* Other waiters may have been woken along with us, so mark M
+	   as contended. */
+	while (xchg (&m->state, 2) != 0)
+		futex (&m->state, FUTEX_WAIT, 2);
+}
+
+/* Wakes up one thread waiting on CV, if any. */
+void
+condvar_signal (struct condvar *cv) {
+	atomic_inc (&cv->seq);
+	futex (&cv->seq, FUTEX_WAKE, 1);
+}
+
+/* Wakes up all threads waiting on CV. */
+void
+condvar_broadcast (struct condvar *cv) {
+	atomic_inc (&cv->seq);
+	futex (&cv->seq, FUTEX_WAKE, INT_MAX);
+}
@@ -194,3 +194,13 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+futex (int *uaddr, int op, int val) {
+	return syscall3 (SYS_FUTEX, uaddr, op, val);
+}
+
+int
+thread_stats (struct thread_stats *stats) {
+	return syscall1 (SYS_THREAD_STATS, stats);
+}
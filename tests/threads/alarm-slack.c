@@ -0,0 +1,129 @@
+/* Runs an alarm-multiple style workload, scaled up to hundreds
+   of sleepers, once with exact wake-up times and once with
+   timer_sleep_range() giving each sleep some slack, while a low
+   priority thread spins in the background.  Every wake pass
+   preempts the spinner, so coalescing the wake-ups of sleepers
+   whose windows overlap should cut the number of wake passes,
+   and with them the number of thread switches.  Both runs do
+   the same sleeps, and the slack makes the second one last
+   longer, so the totals are compared rather than rates.  Checks
+   that both went down, and that no sleeper woke before its
+   minimum. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEPER_CNT 200         /* Number of sleeping threads. */
+#define ITER_CNT 4              /* Sleeps per thread. */
+
+struct round
+  {
+    int slack_pct;              /* Slack, as a percentage of the sleep. */
+    long long switch_cnt;       /* Thread switches while it ran. */
+    long long pass_cnt;         /* Wake passes while it ran. */
+    struct lock lock;           /* Protects done_cnt. */
+    int done_cnt;               /* Sleepers that have finished. */
+    struct semaphore done;      /* Upped when all have finished. */
+    bool early;                 /* Did anyone wake up too soon? */
+  };
+
+static void run_round (struct round *, int slack_pct);
+static thread_func sleeper, spinner;
+
+static volatile bool stop;
+static struct semaphore spinner_done;
+
+void
+test_alarm_slack (void)
+{
+  struct round exact, slack;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  run_round (&exact, 0);
+  run_round (&slack, 25);
+  msg ("Thread switches for %d sleeps: %lld exact, %lld with 25%% slack.",
+       SLEEPER_CNT * ITER_CNT, exact.switch_cnt, slack.switch_cnt);
+  msg ("Wake passes for %d sleeps: %lld exact, %lld with 25%% slack.",
+       SLEEPER_CNT * ITER_CNT, exact.pass_cnt, slack.pass_cnt);
+  if (slack.pass_cnt >= exact.pass_cnt)
+    fail ("slack did not reduce wake passes");
+  if (slack.switch_cnt >= exact.switch_cnt)
+    fail ("slack did not reduce thread switches");
+  pass ();
+}
+
+/* Runs SLEEPER_CNT sleepers, each of which sleeps ITER_CNT times
+   for a duration of its own, with SLACK_PCT percent of slack,
+   and records the thread switches and wake passes in R. */
+static void
+run_round (struct round *r, int slack_pct)
+{
+  int i;
+
+  r->slack_pct = slack_pct;
+  lock_init (&r->lock);
+  r->done_cnt = 0;
+  sema_init (&r->done, 0);
+  r->early = false;
+  stop = false;
+  sema_init (&spinner_done, 0);
+
+  thread_create ("spinner", PRI_MIN, spinner, NULL);
+
+  r->switch_cnt = thread_switch_cnt ();
+  r->pass_cnt = thread_wake_pass_cnt ();
+  for (i = 0; i < SLEEPER_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      thread_create (name, PRI_DEFAULT, sleeper, r);
+    }
+  sema_down (&r->done);
+  r->switch_cnt = thread_switch_cnt () - r->switch_cnt;
+  r->pass_cnt = thread_wake_pass_cnt () - r->pass_cnt;
+  stop = true;
+  sema_down (&spinner_done);
+
+  if (r->early)
+    fail ("a sleeper woke up before its minimum with %d%% slack",
+          slack_pct);
+}
+
+/* Sleeps ITER_CNT times, for a duration that depends on the
+   thread, and checks that each sleep lasts long enough. */
+static void
+sleeper (void *r_)
+{
+  struct round *r = r_;
+  int64_t duration = 50 + thread_tid () % SLEEPER_CNT;
+  int64_t slack = duration * r->slack_pct / 100;
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      int64_t start = timer_ticks ();
+
+      timer_sleep_range (duration, duration + slack);
+      if (timer_elapsed (start) < duration)
+        r->early = true;
+    }
+
+  lock_acquire (&r->lock);
+  if (++r->done_cnt == SLEEPER_CNT)
+    sema_up (&r->done);
+  lock_release (&r->lock);
+}
+
+static void
+spinner (void *aux UNUSED)
+{
+  while (!stop)
+    continue;
+  sema_up (&spinner_done);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Counts vary from run to run, so only check that they were
+# reported.  The test itself fails unless slack cut both.
+fail "Switch counts not reported.\n"
+  if !grep (/^\(alarm-slack\) Thread switches for 800 sleeps: \d+ exact, \d+ with 25% slack\.$/, @output);
+fail "Wake pass counts not reported.\n"
+  if !grep (/^\(alarm-slack\) Wake passes for 800 sleeps: \d+ exact, \d+ with 25% slack\.$/, @output);
+fail "Test did not pass.\n" if !grep (/^\(alarm-slack\) PASS$/, @output);
+pass;
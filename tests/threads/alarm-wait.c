@@ -23,6 +23,15 @@ test_alarm_multiple (void)
 {
   test_sleep (5, 7);
 }
+
+/* Same as alarm-multiple, but with the timer tick stopped
+   whenever the CPU is idle. */
+void
+test_alarm_nohz (void) 
+{
+  ASSERT (timer_nohz);
+  test_sleep (5, 7);
+}
 
 /* Information about the test. */
 struct sleep_test 
@@ -0,0 +1,149 @@
+/* Measures the cost of keeping N sleepers in the timing wheel
+   that backs timer_sleep(), next to the sorted list that it
+   replaced, for growing N.
+
+   For each N, the sleepers are given random wake ticks in
+   [SPAN, 2 * SPAN) and one in eight is cancelled.  The test then
+   reports the average insertion cost and the average cost of a
+   timer tick on which nobody wakes up, which should stay flat
+   for the wheel as N grows.  Finally it checks that every
+   remaining sleeper expires on exactly its own tick and that no
+   cancelled sleeper expires at all. */
+
+#include <stdio.h>
+#include <list.h>
+#include <random.h>
+#include <wheel.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "intrinsic.h"
+
+/* Wake ticks are drawn from [SPAN, 2 * SPAN). */
+#define SPAN 4096
+
+struct sleeper
+  {
+    struct wheel_elem wheel_elem;       /* Element in the wheel. */
+    struct list_elem list_elem;         /* Element in the sorted list. */
+    int64_t wake_tick;                  /* Tick to wake up at. */
+    int64_t woken;                      /* Tick actually woken at, or 0. */
+    bool cancelled;                     /* Removed before expiring? */
+  };
+
+static void measure (int sleeper_cnt);
+static wheel_action_func wake;
+static list_less_func wake_tick_less;
+
+void
+test_alarm_wheel (void)
+{
+  int n;
+
+  msg ("Average cost in TSC cycles per operation.");
+  for (n = 16; n <= 2048; n *= 4)
+    measure (n);
+  pass ();
+}
+
+static void
+measure (int sleeper_cnt)
+{
+  struct sleeper *sleepers;
+  struct wheel *wheel;
+  struct list sorted;
+  uint64_t start, wheel_insert_cycles, wheel_tick_cycles;
+  uint64_t list_insert_cycles, list_tick_cycles;
+  int64_t tick;
+  int i;
+
+  sleepers = malloc (sizeof *sleepers * sleeper_cnt);
+  wheel = malloc (sizeof *wheel);
+  if (sleepers == NULL || wheel == NULL)
+    fail ("out of memory");
+
+  for (i = 0; i < sleeper_cnt; i++)
+    {
+      struct sleeper *s = &sleepers[i];
+      wheel_elem_init (&s->wheel_elem);
+      s->wake_tick = SPAN + random_ulong () % SPAN;
+      s->woken = 0;
+      s->cancelled = i % 8 == 7;
+    }
+
+  /* Timing wheel. */
+  wheel_init (wheel, 1);
+  start = rdtsc ();
+  for (i = 0; i < sleeper_cnt; i++)
+    wheel_insert (wheel, &sleepers[i].wheel_elem, sleepers[i].wake_tick);
+  wheel_insert_cycles = rdtsc () - start;
+
+  for (i = 0; i < sleeper_cnt; i++)
+    if (sleepers[i].cancelled)
+      wheel_remove (wheel, &sleepers[i].wheel_elem);
+
+  start = rdtsc ();
+  for (tick = 1; tick < SPAN; tick++)
+    wheel_advance (wheel, tick, wake, &tick);
+  wheel_tick_cycles = rdtsc () - start;
+
+  for (; tick < 2 * SPAN + WHEEL_SIZE; tick++)
+    wheel_advance (wheel, tick, wake, &tick);
+  if (!wheel_empty (wheel))
+    fail ("%zu sleepers never woke up", wheel_size (wheel));
+
+  for (i = 0; i < sleeper_cnt; i++)
+    {
+      struct sleeper *s = &sleepers[i];
+      if (s->cancelled && s->woken != 0)
+        fail ("cancelled sleeper %d woke up at tick %lld", i, s->woken);
+      else if (!s->cancelled && s->woken != s->wake_tick)
+        fail ("sleeper %d woke up at tick %lld instead of %lld",
+              i, s->woken, s->wake_tick);
+    }
+
+  /* Sorted list, as used before the wheel. */
+  list_init (&sorted);
+  start = rdtsc ();
+  for (i = 0; i < sleeper_cnt; i++)
+    list_insert_ordered (&sorted, &sleepers[i].list_elem,
+                         wake_tick_less, NULL);
+  list_insert_cycles = rdtsc () - start;
+
+  start = rdtsc ();
+  for (tick = 1; tick < SPAN; tick++)
+    while (!list_empty (&sorted)
+           && list_entry (list_front (&sorted), struct sleeper,
+                          list_elem)->wake_tick <= tick)
+      list_pop_front (&sorted);
+  list_tick_cycles = rdtsc () - start;
+
+  msg ("%4d sleepers: wheel insert %6llu tick %4llu, "
+       "sorted list insert %6llu tick %4llu",
+       sleeper_cnt,
+       wheel_insert_cycles / sleeper_cnt, wheel_tick_cycles / (SPAN - 1),
+       list_insert_cycles / sleeper_cnt, list_tick_cycles / (SPAN - 1));
+
+  free (wheel);
+  free (sleepers);
+}
+
+/* Records the tick at which sleeper E woke up. */
+static void
+wake (struct wheel_elem *e, void *tick_)
+{
+  struct sleeper *s = wheel_entry (e, struct sleeper, wheel_elem);
+  int64_t *tick = tick_;
+
+  s->woken = *tick;
+}
+
+/* Orders sleepers by wake tick. */
+static bool
+wake_tick_less (const struct list_elem *a_, const struct list_elem *b_,
+                void *aux UNUSED)
+{
+  const struct sleeper *a = list_entry (a_, struct sleeper, list_elem);
+  const struct sleeper *b = list_entry (b_, struct sleeper, list_elem);
+
+  return a->wake_tick < b->wake_tick;
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timing varies from run to run, so only check that every sleeper
+# count was measured and that the test passed.
+my (@lines) = grep (/^\(alarm-wheel\) +\d+ sleepers: wheel insert/, @output);
+fail "Expected 4 measurements, found " . scalar (@lines) . ".\n"
+  if @lines != 4;
+fail "Test did not pass.\n" if !grep (/^\(alarm-wheel\) PASS$/, @output);
+pass;
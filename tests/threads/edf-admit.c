@@ -0,0 +1,83 @@
+/* Checks EDF admission control and budget enforcement.
+
+   Reservations that would commit more than a CPU are turned
+   down.  Then an EDF thread that never stops running is
+   throttled to its budget, so that an ordinary thread of
+   higher priority still gets the rest of the CPU. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func hog_thread, normal_thread;
+
+static volatile bool stop;
+static volatile int64_t normal_spins;
+static struct semaphore hog_started;
+
+void
+test_edf_admit (void)
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  if (thread_set_edf (0, 10, 10) || thread_set_edf (5, 10, 4)
+      || thread_set_edf (5, 10, 20))
+    fail ("invalid reservation was accepted");
+  if (thread_set_edf (11, 10, 10))
+    fail ("reservation of more than a CPU was accepted");
+  if (!thread_set_edf (6, 10, 10))
+    fail ("reservation of 60% was turned down");
+  msg ("Main thread reserved 60%%.");
+
+  /* The hog's 40% would put the CPU at 100%, over the limit. */
+  sema_init (&hog_started, 0);
+  thread_create ("hog", PRI_MIN, hog_thread, (void *) 4);
+  sema_down (&hog_started);
+
+  /* A 30% hog fits.  It runs flat out, but is throttled to 3
+     ticks in 10, and the ordinary thread gets the rest.  The
+     main thread gives up its reservation so that the two of
+     them are left alone. */
+  thread_clear_edf ();
+  thread_create ("hog", PRI_MIN, hog_thread, (void *) 3);
+  sema_down (&hog_started);
+  thread_create ("normal", PRI_DEFAULT, normal_thread, NULL);
+  thread_set_priority (PRI_MAX);
+  timer_sleep (100);
+  stop = true;
+  timer_sleep (20);
+  thread_set_priority (PRI_DEFAULT);
+
+  if (normal_spins == 0)
+    fail ("the EDF thread starved the ordinary thread");
+  msg ("Ordinary thread ran alongside the EDF thread.");
+}
+
+/* Reserves AUX ticks in every 10 and, if that works, runs
+   without ever yielding until told to stop. */
+static void
+hog_thread (void *aux)
+{
+  int64_t runtime = (int64_t) aux;
+
+  if (!thread_set_edf (runtime, 10, 10))
+    {
+      msg ("Reservation of %lld0%% was turned down.", runtime);
+      sema_up (&hog_started);
+      return;
+    }
+  msg ("Reservation of %lld0%% was accepted.", runtime);
+  sema_up (&hog_started);
+  while (!stop)
+    continue;
+}
+
+static void
+normal_thread (void *aux UNUSED)
+{
+  while (!stop)
+    normal_spins++;
+}
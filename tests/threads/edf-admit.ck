@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-admit) begin
+(edf-admit) Main thread reserved 60%.
+(edf-admit) Reservation of 40% was turned down.
+(edf-admit) Reservation of 30% was accepted.
+(edf-admit) Ordinary thread ran alongside the EDF thread.
+(edf-admit) end
+EOF
+pass;
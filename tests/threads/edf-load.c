@@ -0,0 +1,98 @@
+/* Runs two periodic EDF threads against three CPU-bound
+   threads of the highest priority and measures how many
+   deadlines the EDF threads miss.  Together they reserve 70% of
+   the CPU and use 50%, so they should miss none. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SPINNER_CNT 3
+
+struct periodic
+  {
+    const char *name;
+    int64_t runtime;            /* Reserved ticks per period. */
+    int64_t period;             /* Period, in ticks. */
+    int64_t work;               /* Ticks of CPU time used per period. */
+    int64_t job_cnt;            /* Periods to run. */
+    int64_t jobs, misses;       /* Results. */
+  };
+
+static thread_func periodic_thread, spinner_thread;
+
+static volatile bool stop;
+static int running_cnt;
+static struct semaphore started, finished;
+
+void
+test_edf_load (void)
+{
+  struct periodic p[2] =
+    {
+      {"A", 3, 10, 2, 30, 0, 0},
+      {"B", 2, 5, 1, 60, 0, 0},
+    };
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&started, 0);
+  sema_init (&finished, 0);
+  running_cnt = 2;
+  for (i = 0; i < 2; i++)
+    thread_create (p[i].name, PRI_DEFAULT, periodic_thread, &p[i]);
+  for (i = 0; i < 2; i++)
+    sema_down (&started);
+
+  thread_set_priority (PRI_MAX);
+  for (i = 0; i < SPINNER_CNT; i++)
+    thread_create ("spinner", PRI_MAX, spinner_thread, NULL);
+  sema_down (&finished);
+  thread_set_priority (PRI_DEFAULT);
+
+  for (i = 0; i < 2; i++)
+    msg ("Thread %s: %lld jobs, %lld deadline misses, miss rate %lld%%.",
+         p[i].name, p[i].jobs, p[i].misses, p[i].misses * 100 / p[i].jobs);
+}
+
+/* Does WORK ticks of computation every period, JOB_CNT times. */
+static void
+periodic_thread (void *p_)
+{
+  struct periodic *p = p_;
+  struct thread *t = thread_current ();
+  int64_t i;
+
+  if (!thread_set_edf (p->runtime, p->period, p->period))
+    fail ("reservation for thread %s was turned down", p->name);
+  sema_up (&started);
+
+  for (i = 0; i < p->job_cnt; i++)
+    {
+      /* Spin until this thread has run for WORK ticks. */
+      int64_t budget = t->edf_budget - p->work;
+
+      while (t->edf_budget > budget)
+        barrier ();
+      thread_edf_yield ();
+    }
+  thread_get_edf_stats (&p->jobs, &p->misses);
+  thread_clear_edf ();
+
+  if (--running_cnt == 0)
+    {
+      stop = true;
+      sema_up (&finished);
+    }
+}
+
+static void
+spinner_thread (void *aux UNUSED)
+{
+  while (!stop)
+    continue;
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-load) begin
+(edf-load) Thread A: 30 jobs, 0 deadline misses, miss rate 0%.
+(edf-load) Thread B: 60 jobs, 0 deadline misses, miss rate 0%.
+(edf-load) end
+EOF
+pass;
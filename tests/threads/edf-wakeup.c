@@ -0,0 +1,37 @@
+/* Checks that an EDF thread that blocks in the middle of a
+   period is given a new period when it wakes up, if it has too
+   much budget left to use up by its old deadline.
+
+   The main thread reserves 10 ticks in every 100 and sleeps
+   through 95 of them without using any.  Then it runs for 6
+   ticks, which takes it past its first deadline.  Since it
+   woke with 10 ticks of budget and only 5 until that deadline,
+   it should be running against a new one by then. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+void
+test_edf_wakeup (void)
+{
+  int64_t start, jobs, misses;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  if (!thread_set_edf (10, 100, 100))
+    fail ("reservation of 10%% was turned down");
+  timer_sleep (95);
+  start = timer_ticks ();
+  while (timer_elapsed (start) < 6)
+    continue;
+  thread_edf_yield ();
+  thread_get_edf_stats (&jobs, &misses);
+  thread_clear_edf ();
+
+  if (jobs != 1 || misses != 0)
+    fail ("%lld jobs, %lld deadline misses", jobs, misses);
+  msg ("Woken thread met its new deadline.");
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-wakeup) begin
+(edf-wakeup) Woken thread met its new deadline.
+(edf-wakeup) end
+EOF
+pass;
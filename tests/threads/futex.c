@@ -0,0 +1,67 @@
+/* Tests the kernel side of futexes: futex_wait() returns at once
+   if the value has changed, futex_wake() wakes the sleepers on
+   one futex only, highest priority first, and reports how many it
+   woke.  The futex system call only adds the translation of user
+   addresses to these. */
+
+#include <limits.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/futex.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+
+#define WAITER_CNT 5
+
+static thread_func futex_thread;
+static int word;
+static int other;
+
+void
+test_futex (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  word = 1;
+  if (futex_wait (&word, 0) != -1)
+    fail ("futex_wait slept on a changed value");
+  msg ("futex_wait on a changed value returned at once.");
+  if (futex_wake (&word, INT_MAX) != 0)
+    fail ("futex_wake woke a thread that was not there");
+  msg ("futex_wake with no sleepers woke nobody.");
+
+  word = other = 0;
+  thread_set_priority (PRI_MIN);
+  thread_create ("other", PRI_DEFAULT, futex_thread, &other);
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      int priority = PRI_DEFAULT - (i + 3) % WAITER_CNT - 1;
+      char name[16];
+      snprintf (name, sizeof name, "priority %d", priority);
+      thread_create (name, priority, futex_thread, &word);
+    }
+
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      msg ("Waking one...");
+      if (futex_wake (&word, 1) != 1)
+        fail ("futex_wake did not wake exactly one thread");
+    }
+  if (futex_wake (&word, INT_MAX) != 0)
+    fail ("futex_wake found a sleeper on an emptied futex");
+  msg ("Waking the other futex...");
+  if (futex_wake (&other, INT_MAX) != 1)
+    fail ("futex_wake did not wake the other futex's sleeper");
+}
+
+static void
+futex_thread (void *futex) 
+{
+  msg ("Thread %s waiting.", thread_name ());
+  if (futex_wait (futex, 0) != 0)
+    fail ("futex_wait did not sleep");
+  msg ("Thread %s woke up.", thread_name ());
+}
@@ -0,0 +1,29 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex) begin
+(futex) futex_wait on a changed value returned at once.
+(futex) futex_wake with no sleepers woke nobody.
+(futex) Thread other waiting.
+(futex) Thread priority 27 waiting.
+(futex) Thread priority 26 waiting.
+(futex) Thread priority 30 waiting.
+(futex) Thread priority 29 waiting.
+(futex) Thread priority 28 waiting.
+(futex) Waking one...
+(futex) Thread priority 30 woke up.
+(futex) Waking one...
+(futex) Thread priority 29 woke up.
+(futex) Waking one...
+(futex) Thread priority 28 woke up.
+(futex) Waking one...
+(futex) Thread priority 27 woke up.
+(futex) Waking one...
+(futex) Thread priority 26 woke up.
+(futex) Waking the other futex...
+(futex) Thread other woke up.
+(futex) end
+EOF
+pass;
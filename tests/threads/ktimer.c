@@ -0,0 +1,98 @@
+/* Checks that kernel timers run in order of deadline, never
+   before their deadline, that a cancelled timer does not run,
+   and that a sleep shorter than a tick blocks, letting a lower
+   priority thread run, instead of busy-waiting. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define TIMER_CNT 3
+
+struct fired
+  {
+    struct ktimer timer;
+    int id;
+  };
+
+static ktimer_func record_fire;
+static thread_func spinner;
+
+static int order[TIMER_CNT + 1];
+static int fire_cnt;
+static bool early;
+static struct semaphore all_fired;
+static volatile bool stop;
+static volatile int spins;
+
+void
+test_ktimer (void)
+{
+  static const int delays_us[TIMER_CNT] = {3000, 1000, 2000};
+  struct fired f[TIMER_CNT + 1];
+  int64_t start;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&all_fired, 0);
+
+  /* Add timers out of order, all due well before the next tick
+     could be counted on, and one more that is cancelled. */
+  start = timer_ns ();
+  for (i = 0; i <= TIMER_CNT; i++)
+    {
+      int64_t delay = i < TIMER_CNT ? delays_us[i] : 1500;
+
+      f[i].id = i;
+      ktimer_init (&f[i].timer);
+      timer_add (&f[i].timer, start + delay * 1000, record_fire, &f[i]);
+    }
+  if (!timer_cancel (&f[TIMER_CNT].timer))
+    fail ("cancelling a pending timer failed");
+  sema_down (&all_fired);
+
+  for (i = 0; i < fire_cnt; i++)
+    msg ("Timer %d fired.", order[i]);
+  if (early)
+    fail ("a timer fired before its deadline");
+  if (timer_cancel (&f[0].timer))
+    fail ("cancelling a timer that already ran succeeded");
+
+  /* Sleep for less than a tick while a lower priority thread
+     spins.  It can only spin if we block. */
+  thread_create ("spinner", PRI_DEFAULT - 1, spinner, NULL);
+  start = timer_ns ();
+  timer_usleep (2000);
+  if (timer_ns () - start < 2000 * 1000)
+    fail ("timer_usleep(2000) returned early");
+  if (spins == 0)
+    fail ("timer_usleep(2000) did not let other threads run");
+  msg ("Lower priority thread ran during a 2 ms sleep.");
+  stop = true;
+}
+
+/* ktimer_func that records which timer fired. */
+static void
+record_fire (void *f_)
+{
+  struct fired *f = f_;
+
+  ASSERT (intr_context ());
+  if (timer_ns () < f->timer.deadline)
+    early = true;
+  order[fire_cnt++] = f->id;
+  if (fire_cnt == TIMER_CNT)
+    sema_up (&all_fired);
+}
+
+static void
+spinner (void *aux UNUSED)
+{
+  while (!stop)
+    spins++;
+}
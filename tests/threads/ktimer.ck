@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ktimer) begin
+(ktimer) Timer 1 fired.
+(ktimer) Timer 2 fired.
+(ktimer) Timer 0 fired.
+(ktimer) Lower priority thread ran during a 2 ms sleep.
+(ktimer) end
+EOF
+pass;
@@ -0,0 +1,82 @@
+/* Measures the cost of an uncontended lock_acquire() and
+   lock_release() pair, and compares it with the sequence that the
+   lock used to be built on: a binary semaphore taken and
+   released with interrupts turned off around it.
+
+   The lock's fast path should come out several times cheaper.
+   Timings depend on the host, so the test only fails if the lock
+   stops working: it also checks that a waiter on a contended
+   lock still gets it, and still donates its priority. */
+
+#include <stdio.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ITER_CNT 100000
+
+static thread_func waiter_thread;
+
+void
+test_lock_fast (void)
+{
+  struct lock lock;
+  struct semaphore sema;
+  enum intr_level old_level;
+  uint64_t start, lock_cycles, sema_cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&lock);
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      lock_acquire (&lock);
+      lock_release (&lock);
+    }
+  lock_cycles = rdtsc () - start;
+
+  sema_init (&sema, 1);
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      old_level = intr_disable ();
+      sema_down (&sema);
+      intr_set_level (old_level);
+      old_level = intr_disable ();
+      sema_up (&sema);
+      intr_set_level (old_level);
+    }
+  sema_cycles = rdtsc () - start;
+
+  msg ("lock: %llu cycles per acquire/release pair.",
+       (unsigned long long) (lock_cycles / ITER_CNT));
+  msg ("semaphore: %llu cycles per down/up pair.",
+       (unsigned long long) (sema_cycles / ITER_CNT));
+
+  /* Contended case: the waiter must block, donate, and be woken. */
+  lock_acquire (&lock);
+  thread_create ("waiter", PRI_DEFAULT + 1, waiter_thread, &lock);
+  if (thread_get_priority () != PRI_DEFAULT + 1)
+    fail ("waiter did not donate its priority");
+  lock_release (&lock);
+  if (thread_get_priority () != PRI_DEFAULT)
+    fail ("donation was not returned");
+  if (!lock_try_acquire (&lock))
+    fail ("waiter did not release the lock");
+  lock_release (&lock);
+  pass ();
+}
+
+static void
+waiter_thread (void *lock_)
+{
+  struct lock *lock = lock_;
+
+  lock_acquire (lock);
+  lock_release (lock);
+}
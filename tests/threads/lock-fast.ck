@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timings depend on the host, so only check that they were
+# measured and that the test passed.
+fail "Lock timing was not reported.\n"
+  if !grep (/^\(lock-fast\) lock: \d+ cycles per acquire\/release pair\.$/,
+	    @output);
+fail "Semaphore timing was not reported.\n"
+  if !grep (/^\(lock-fast\) semaphore: \d+ cycles per down\/up pair\.$/,
+	    @output);
+fail "Test did not pass.\n" if !grep (/^\(lock-fast\) PASS$/, @output);
+pass;
@@ -0,0 +1,99 @@
+/* Checks that refreshing the priorities of ready threads under
+   the MLFQS, once a second after recent_cpu decays, does not keep
+   interrupts off for longer with more threads ready.
+
+   The main thread measures the longest interrupts-off section in
+   each second, first alone and then with 1000 more threads
+   spinning, and so ready, at a lower priority.  A section can
+   also be stretched by the host, so the smallest of several
+   seconds' worth is used. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 1000
+#define SECONDS 3
+
+static volatile bool stop;
+static struct semaphore done;
+
+static uint64_t irqsoff_cost (void);
+static void spinning_thread (void *aux);
+
+void
+test_mlfqs_ready_cost (void) 
+{
+  bool trace = intr_irqsoff_trace;
+  uint64_t alone, crowded;
+  int i;
+
+  ASSERT (thread_mlfqs);
+
+  sema_init (&done, 0);
+  intr_irqsoff_trace = true;
+
+  alone = irqsoff_cost ();
+
+  /* The new threads inherit our niceness, so they stay below us
+     once we are back to the default. */
+  msg ("Creating %d ready threads...", THREAD_CNT);
+  thread_set_nice (NICE_MAX);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "ready %d", i);
+      if (thread_create (name, PRI_DEFAULT, spinning_thread, NULL)
+          == TID_ERROR)
+        fail ("could not create thread %d", i);
+    }
+  thread_set_nice (NICE_DEFAULT);
+
+  crowded = irqsoff_cost ();
+  intr_irqsoff_trace = trace;
+
+  if (crowded > 2 * alone)
+    fail ("interrupts were off for up to %llu cycles alone, "
+          "but %llu cycles with %d threads ready",
+          (unsigned long long) alone, (unsigned long long) crowded,
+          THREAD_CNT);
+  msg ("Interrupts-off time did not grow with the ready thread count.");
+
+  stop = true;
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  msg ("All threads finished.");
+}
+
+/* Returns the smallest, over SECONDS seconds, of the longest
+   interrupts-off section in each second. */
+static uint64_t
+irqsoff_cost (void) 
+{
+  uint64_t cost = UINT64_MAX;
+  int i;
+
+  for (i = 0; i < SECONDS; i++)
+    {
+      uint64_t max;
+
+      intr_irqsoff_reset ();
+      timer_sleep (TIMER_FREQ);
+      max = intr_irqsoff_max ();
+      if (max < cost)
+        cost = max;
+    }
+  return cost;
+}
+
+static void
+spinning_thread (void *aux UNUSED) 
+{
+  while (!stop)
+    continue;
+  sema_up (&done);
+}
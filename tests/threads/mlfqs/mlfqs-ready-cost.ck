@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(mlfqs-ready-cost) begin
+(mlfqs-ready-cost) Creating 1000 ready threads...
+(mlfqs-ready-cost) Interrupts-off time did not grow with the ready thread count.
+(mlfqs-ready-cost) All threads finished.
+(mlfqs-ready-cost) end
+EOF
+pass;
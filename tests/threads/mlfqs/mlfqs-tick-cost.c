@@ -0,0 +1,101 @@
+/* Checks that the cost of the timer interrupt under the MLFQS
+   does not grow with the number of threads.
+
+   The main thread measures how long the timer interrupt takes
+   away from it, including the once-a-second decay of recent_cpu,
+   first alone and then with 1000 more threads blocked.  The
+   measurement is the longest gap between two consecutive reads
+   of the time stamp counter over a second, which catches the
+   second boundary.  A gap can also come from the host, so the
+   smallest of several seconds' worth is used. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define THREAD_CNT 1000
+#define SECONDS 3
+
+static struct semaphore go, done;
+
+static uint64_t tick_cost (void);
+static void blocked_thread (void *aux);
+
+void
+test_mlfqs_tick_cost (void) 
+{
+  uint64_t alone, crowded;
+  int i;
+
+  ASSERT (thread_mlfqs);
+
+  sema_init (&go, 0);
+  sema_init (&done, 0);
+
+  alone = tick_cost ();
+
+  msg ("Creating %d blocked threads...", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "blocked %d", i);
+      if (thread_create (name, PRI_DEFAULT, blocked_thread, NULL)
+          == TID_ERROR)
+        fail ("could not create thread %d", i);
+    }
+
+  /* Let them all block. */
+  timer_sleep (TIMER_FREQ);
+  crowded = tick_cost ();
+
+  if (crowded > 2 * alone)
+    fail ("timer interrupt took up to %llu cycles alone, "
+          "but %llu cycles with %d threads",
+          (unsigned long long) alone, (unsigned long long) crowded,
+          THREAD_CNT);
+  msg ("Timer interrupt cost did not grow with the thread count.");
+
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_up (&go);
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  msg ("All threads finished.");
+}
+
+/* Returns the smallest, over SECONDS seconds, of the longest time
+   in each second that the running thread did not run. */
+static uint64_t
+tick_cost (void) 
+{
+  uint64_t cost = UINT64_MAX;
+  int i;
+
+  for (i = 0; i < SECONDS; i++)
+    {
+      int64_t end = timer_ticks () + TIMER_FREQ;
+      uint64_t prev = rdtsc ();
+      uint64_t max = 0;
+
+      while (timer_ticks () < end)
+        {
+          uint64_t now = rdtsc ();
+          if (now - prev > max)
+            max = now - prev;
+          prev = now;
+        }
+      if (max < cost)
+        cost = max;
+    }
+  return cost;
+}
+
+static void
+blocked_thread (void *aux UNUSED) 
+{
+  sema_down (&go);
+  sema_up (&done);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(mlfqs-tick-cost) begin
+(mlfqs-tick-cost) Creating 1000 blocked threads...
+(mlfqs-tick-cost) Timer interrupt cost did not grow with the thread count.
+(mlfqs-tick-cost) All threads finished.
+(mlfqs-tick-cost) end
+EOF
+pass;
@@ -0,0 +1,236 @@
+/* Measures the throughput of the page allocator and how well it
+   resists fragmentation, and checks that it coalesces.
+
+   First it times single-page allocations, and allocations of
+   mixed sizes.  Then it times the same random allocations and
+   frees against palloc and against a first-fit bitmap allocator
+   like the one the pools used to have.  The first-fit bitmap
+   covers only the largest block that palloc can allocate, not
+   the whole pool, which if anything favours it.  Timings depend
+   on the host, so they are only reported.
+
+   Then it finds the largest power-of-two block that can be
+   allocated, churns the kernel pool with random allocations and
+   frees of 1 to 16 pages, reports the largest block still
+   available with half of the blocks allocated, frees everything,
+   and checks that the original largest block can be allocated
+   again.  Every page is tagged with its owner while it
+   is allocated, so that overlapping allocations are caught. */
+
+#include <stdio.h>
+#include <bitmap.h>
+#include <random.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+#define SINGLE_CNT 10000        /* Single-page get/free pairs. */
+#define SLOT_CNT 256            /* Blocks live at once, at most. */
+#define CHURN_CNT 8000          /* Random allocations and frees. */
+#define MAX_PROBE 4096          /* Largest block probed for, in pages. */
+
+struct slot
+  {
+    uint8_t *pages;             /* Block, or a null pointer. */
+    size_t page_cnt;            /* Its size in pages. */
+  };
+
+static struct slot slots[SLOT_CNT];
+
+/* The old first-fit pool, for comparison: a bitmap of used
+   pages, scanned from the start under a lock. */
+static struct bitmap *ff_map;
+static struct lock ff_lock;
+static size_t ff_idx[SLOT_CNT];    /* First page of each block plus 1, or 0. */
+
+static uint64_t churn_cycles (bool first_fit, unsigned seed);
+static size_t largest_block (void);
+static bool get_block (int slot, size_t page_cnt);
+static void free_block (int slot);
+
+void
+test_palloc_buddy (void)
+{
+  uint64_t start, single_cycles, mixed_cycles, buddy_cycles, ff_cycles;
+  size_t before, during, after;
+  int mixed_ops = 0;
+  int i, round;
+
+  /* Throughput. */
+  start = rdtsc ();
+  for (i = 0; i < SINGLE_CNT; i++)
+    palloc_free_page (palloc_get_page (PAL_ASSERT));
+  single_cycles = rdtsc () - start;
+
+  start = rdtsc ();
+  for (round = 0; round < 50; round++)
+    {
+      for (i = 0; i < 64; i++)
+        {
+          size_t page_cnt = 1 + random_ulong () % 8;
+          if (!get_block (i, page_cnt))
+            fail ("cannot allocate %zu pages", page_cnt);
+        }
+      for (i = 0; i < 64; i++)
+        free_block (i);
+      mixed_ops += 128;
+    }
+  mixed_cycles = rdtsc () - start;
+
+  msg ("single page: %llu cycles per get/free pair.",
+       (unsigned long long) (single_cycles / SINGLE_CNT));
+  msg ("mixed sizes: %llu cycles per get or free.",
+       (unsigned long long) (mixed_cycles / mixed_ops));
+
+  /* Comparison with first fit. */
+  before = largest_block ();
+  ff_map = bitmap_create (before);
+  if (ff_map == NULL)
+    fail ("cannot allocate the first-fit bitmap");
+  lock_init (&ff_lock);
+  buddy_cycles = churn_cycles (false, 1);
+  ff_cycles = churn_cycles (true, 1);
+  bitmap_destroy (ff_map);
+  msg ("buddy: %llu cycles per get or free under churn.",
+       (unsigned long long) (buddy_cycles / CHURN_CNT));
+  msg ("first fit: %llu cycles per get or free under churn.",
+       (unsigned long long) (ff_cycles / CHURN_CNT));
+
+  /* Fragmentation. */
+  for (i = 0; i < CHURN_CNT; i++)
+    {
+      int s = random_ulong () % SLOT_CNT;
+
+      if (slots[s].pages != NULL)
+        free_block (s);
+      else
+        {
+          /* Mostly small blocks, now and then a larger one. */
+          size_t page_cnt = 1 + random_ulong () % (i % 4 == 0 ? 16 : 4);
+          get_block (s, page_cnt);
+        }
+    }
+  during = largest_block ();
+  msg ("largest free block: %zu pages before churn, %zu during.",
+       before, during);
+
+  for (i = 0; i < SLOT_CNT; i++)
+    if (slots[i].pages != NULL)
+      free_block (i);
+  after = largest_block ();
+  if (after < before)
+    fail ("largest free block shrank from %zu to %zu pages "
+          "after freeing everything", before, after);
+  msg ("Freed blocks were coalesced.");
+  pass ();
+}
+
+/* Runs CHURN_CNT random allocations and frees of 1 to 16 pages,
+   the same ones for the same SEED, against the first-fit bitmap
+   if FIRST_FIT is true or palloc otherwise, then frees whatever
+   is left.  Returns the cycles that the allocations and frees
+   took.  The pages are not touched, since the first-fit bitmap
+   has none behind it. */
+static uint64_t
+churn_cycles (bool first_fit, unsigned seed)
+{
+  uint64_t cycles = 0;
+  int i;
+
+  random_init (seed);
+  for (i = 0; i < CHURN_CNT; i++)
+    {
+      int s = random_ulong () % SLOT_CNT;
+      size_t page_cnt = 1 + random_ulong () % (i % 4 == 0 ? 16 : 4);
+      uint64_t start = rdtsc ();
+
+      if (first_fit && ff_idx[s] != 0)
+        {
+          bitmap_set_multiple (ff_map, ff_idx[s] - 1, slots[s].page_cnt,
+                               false);
+          ff_idx[s] = 0;
+        }
+      else if (first_fit)
+        {
+          /* BITMAP_ERROR + 1 is 0, meaning no block. */
+          lock_acquire (&ff_lock);
+          ff_idx[s] = bitmap_scan_and_flip (ff_map, 0, page_cnt, false) + 1;
+          lock_release (&ff_lock);
+          slots[s].page_cnt = page_cnt;
+        }
+      else if (slots[s].pages != NULL)
+        {
+          palloc_free_multiple (slots[s].pages, slots[s].page_cnt);
+          slots[s].pages = NULL;
+        }
+      else
+        {
+          slots[s].pages = palloc_get_multiple (0, page_cnt);
+          slots[s].page_cnt = page_cnt;
+        }
+      cycles += rdtsc () - start;
+    }
+
+  for (i = 0; i < SLOT_CNT; i++)
+    {
+      if (first_fit && ff_idx[i] != 0)
+        bitmap_set_multiple (ff_map, ff_idx[i] - 1, slots[i].page_cnt, false);
+      else if (!first_fit && slots[i].pages != NULL)
+        palloc_free_multiple (slots[i].pages, slots[i].page_cnt);
+      ff_idx[i] = 0;
+      slots[i].pages = NULL;
+    }
+  return cycles;
+}
+
+/* Returns the size of the largest block of a power-of-two
+   number of pages, up to MAX_PROBE, that can be allocated. */
+static size_t
+largest_block (void)
+{
+  size_t page_cnt;
+
+  for (page_cnt = MAX_PROBE; page_cnt > 0; page_cnt /= 2)
+    {
+      void *pages = palloc_get_multiple (0, page_cnt);
+      if (pages != NULL)
+        {
+          palloc_free_multiple (pages, page_cnt);
+          return page_cnt;
+        }
+    }
+  return 0;
+}
+
+/* Allocates PAGE_CNT pages into SLOT and tags each of them.
+   Returns false if there are not enough. */
+static bool
+get_block (int slot, size_t page_cnt)
+{
+  struct slot *s = &slots[slot];
+  size_t i;
+
+  s->pages = palloc_get_multiple (0, page_cnt);
+  if (s->pages == NULL)
+    return false;
+  s->page_cnt = page_cnt;
+  for (i = 0; i < page_cnt; i++)
+    *(int *) (s->pages + i * PGSIZE) = slot;
+  return true;
+}
+
+/* Checks the tags of the block in SLOT, and frees it. */
+static void
+free_block (int slot)
+{
+  struct slot *s = &slots[slot];
+  size_t i;
+
+  for (i = 0; i < s->page_cnt; i++)
+    if (*(int *) (s->pages + i * PGSIZE) != slot)
+      fail ("page %zu of block %d was overwritten", i, slot);
+  palloc_free_multiple (s->pages, s->page_cnt);
+  s->pages = NULL;
+}
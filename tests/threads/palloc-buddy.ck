@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timings and block sizes depend on the host and on the memory
+# layout, so only check that they were reported.  The test itself
+# fails unless freed blocks coalesce.
+fail "Single-page timing was not reported.\n"
+  if !grep (/^\(palloc-buddy\) single page: \d+ cycles per get\/free pair\.$/,
+	    @output);
+fail "Mixed-size timing was not reported.\n"
+  if !grep (/^\(palloc-buddy\) mixed sizes: \d+ cycles per get or free\.$/,
+	    @output);
+fail "Churn timings were not reported.\n"
+  if !grep (/^\(palloc-buddy\) buddy: \d+ cycles per get or free under churn\.$/,
+	    @output)
+     || !grep (/^\(palloc-buddy\) first fit: \d+ cycles per get or free under churn\.$/,
+	       @output);
+fail "Fragmentation was not reported.\n"
+  if !grep (/^\(palloc-buddy\) largest free block: \d+ pages before churn, \d+ during\.$/,
+	    @output);
+fail "Test did not pass.\n" if !grep (/^\(palloc-buddy\) PASS$/, @output);
+pass;
@@ -0,0 +1,75 @@
+/* Measures the reserve of pre-zeroed pages.
+
+   Times single-page PAL_ZERO allocations from the kernel pool
+   with the reserve turned off, then turns it on, sleeps so that
+   the idle thread can fill it, and times them again.  Checks
+   that every page comes back zeroed either way, even though
+   freed pages are poisoned in debug builds. */
+
+#include <stdio.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define PAGE_CNT 32             /* Pages per measurement. */
+
+static uint8_t *pages[PAGE_CNT];
+
+static uint64_t get_zeroed_pages (void);
+static void free_pages (void);
+
+void
+test_palloc_prezero (void)
+{
+  bool saved = palloc_prezero;
+  uint64_t off_cycles, on_cycles;
+
+  palloc_prezero = false;
+  off_cycles = get_zeroed_pages ();
+  free_pages ();
+
+  palloc_prezero = true;
+  timer_sleep (TIMER_FREQ / 10);
+  on_cycles = get_zeroed_pages ();
+  free_pages ();
+  palloc_prezero = saved;
+
+  msg ("without reserve: %llu cycles per zeroed page.",
+       (unsigned long long) (off_cycles / PAGE_CNT));
+  msg ("with reserve: %llu cycles per zeroed page.",
+       (unsigned long long) (on_cycles / PAGE_CNT));
+  pass ();
+}
+
+/* Allocates PAGE_CNT zeroed pages into pages[], checks that they
+   are zeroed, and returns the cycles that allocation took. */
+static uint64_t
+get_zeroed_pages (void)
+{
+  uint64_t start, cycles;
+  int i;
+  size_t j;
+
+  start = rdtsc ();
+  for (i = 0; i < PAGE_CNT; i++)
+    pages[i] = palloc_get_page (PAL_ZERO | PAL_ASSERT);
+  cycles = rdtsc () - start;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    for (j = 0; j < PGSIZE; j++)
+      if (pages[i][j] != 0)
+        fail ("byte %zu of page %d is not zero", j, i);
+  return cycles;
+}
+
+/* Frees the pages in pages[]. */
+static void
+free_pages (void)
+{
+  int i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    palloc_free_page (pages[i]);
+}
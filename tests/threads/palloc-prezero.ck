@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timings depend on the host, so only check that they were
+# reported and that the test passed.
+fail "Timing without the reserve was not reported.\n"
+  if !grep (/^\(palloc-prezero\) without reserve: \d+ cycles per zeroed page\.$/,
+	    @output);
+fail "Timing with the reserve was not reported.\n"
+  if !grep (/^\(palloc-prezero\) with reserve: \d+ cycles per zeroed page\.$/,
+	    @output);
+fail "Test did not pass.\n" if !grep (/^\(palloc-prezero\) PASS$/, @output);
+pass;
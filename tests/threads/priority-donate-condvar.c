@@ -0,0 +1,93 @@
+/* Low priority thread L acquires lock A and then waits on a
+   condition variable.  Medium priority thread M then waits on
+   the same condition variable.  Next, high priority thread H
+   attempts to acquire lock A, donating its priority to L while L
+   is still waiting.
+
+   The main thread then signals the condition variable once.  L,
+   now of higher priority than M, must be the one to wake up.  It
+   releases lock A, which lets H run, and finishes.  Finally the
+   main thread signals again to wake up M.  */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct locks_and_cond 
+  {
+    struct lock a;              /* Lock that H wants from L. */
+    struct lock b;              /* Lock protecting the condition. */
+    struct condition cond;
+  };
+
+static thread_func l_thread_func;
+static thread_func m_thread_func;
+static thread_func h_thread_func;
+
+void
+test_priority_donate_condvar (void) 
+{
+  struct locks_and_cond lc;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  lock_init (&lc.a);
+  lock_init (&lc.b);
+  cond_init (&lc.cond);
+  thread_create ("low", PRI_DEFAULT + 1, l_thread_func, &lc);
+  thread_create ("med", PRI_DEFAULT + 3, m_thread_func, &lc);
+  thread_create ("high", PRI_DEFAULT + 5, h_thread_func, &lc);
+
+  lock_acquire (&lc.b);
+  msg ("Main thread signaling.");
+  cond_signal (&lc.cond, &lc.b);
+  lock_release (&lc.b);
+
+  lock_acquire (&lc.b);
+  msg ("Main thread signaling again.");
+  cond_signal (&lc.cond, &lc.b);
+  lock_release (&lc.b);
+  msg ("Main thread finished.");
+}
+
+static void
+l_thread_func (void *lc_) 
+{
+  struct locks_and_cond *lc = lc_;
+
+  lock_acquire (&lc->a);
+  lock_acquire (&lc->b);
+  cond_wait (&lc->cond, &lc->b);
+  msg ("Thread L woke up.");
+  lock_release (&lc->b);
+  lock_release (&lc->a);
+  msg ("Thread L finished.");
+}
+
+static void
+m_thread_func (void *lc_) 
+{
+  struct locks_and_cond *lc = lc_;
+
+  lock_acquire (&lc->b);
+  cond_wait (&lc->cond, &lc->b);
+  msg ("Thread M woke up.");
+  lock_release (&lc->b);
+}
+
+static void
+h_thread_func (void *lc_) 
+{
+  struct locks_and_cond *lc = lc_;
+
+  lock_acquire (&lc->a);
+  msg ("Thread H acquired lock.");
+  lock_release (&lc->a);
+  msg ("Thread H finished.");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-condvar) begin
+(priority-donate-condvar) Main thread signaling.
+(priority-donate-condvar) Thread L woke up.
+(priority-donate-condvar) Thread H acquired lock.
+(priority-donate-condvar) Thread H finished.
+(priority-donate-condvar) Thread L finished.
+(priority-donate-condvar) Main thread signaling again.
+(priority-donate-condvar) Thread M woke up.
+(priority-donate-condvar) Main thread finished.
+(priority-donate-condvar) end
+EOF
+pass;
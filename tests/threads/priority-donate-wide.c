@@ -0,0 +1,102 @@
+/* A low priority thread acquires a lock and then blocks on a
+   semaphore.  WAITER_CNT threads, with priorities spread over the
+   whole range above it, then queue up for the lock, one by one.
+   The holder must receive the highest of their priorities, and
+   once it releases the lock the waiters must get it in order of
+   priority, and in order of arrival among waiters of equal
+   priority.  With hundreds of waiters, this exercises the
+   donation bookkeeping much harder than the other
+   priority-donate tests. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define WAITER_CNT 200
+
+struct waiter
+  {
+    int priority;               /* Priority of the waiting thread. */
+    int arrival;                /* Index in order of creation. */
+  };
+
+static struct lock lock;
+static struct semaphore release, done;
+static struct thread *holder;
+
+static struct waiter waiters[WAITER_CNT];
+static struct waiter *order[WAITER_CNT];
+static int order_cnt;
+
+static thread_func holder_func;
+static thread_func waiter_func;
+
+void
+test_priority_donate_wide (void) 
+{
+  int span = PRI_MAX - (PRI_DEFAULT + 1);
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  lock_init (&lock);
+  sema_init (&release, 0);
+  sema_init (&done, 0);
+  thread_create ("holder", PRI_DEFAULT + 1, holder_func, NULL);
+
+  order_cnt = 0;
+  for (i = 0; i < WAITER_CNT; i++)
+    {
+      char name[16];
+
+      waiters[i].priority = PRI_DEFAULT + 2 + (i * 7) % span;
+      waiters[i].arrival = i;
+      snprintf (name, sizeof name, "waiter %d", i);
+      thread_create (name, waiters[i].priority, waiter_func, &waiters[i]);
+    }
+  msg ("Holder should have priority %d.  Actual priority: %d.",
+       PRI_MAX, holder->priority);
+
+  sema_up (&release);
+  sema_down (&done);
+
+  if (order_cnt != WAITER_CNT)
+    fail ("only %d of %d waiters got the lock", order_cnt, WAITER_CNT);
+  for (i = 1; i < WAITER_CNT; i++)
+    if (order[i]->priority > order[i - 1]->priority
+        || (order[i]->priority == order[i - 1]->priority
+            && order[i]->arrival < order[i - 1]->arrival))
+      fail ("waiter %d (priority %d) got the lock after "
+            "waiter %d (priority %d)",
+            order[i]->arrival, order[i]->priority,
+            order[i - 1]->arrival, order[i - 1]->priority);
+  msg ("All %d waiters got the lock in order.", WAITER_CNT);
+}
+
+static void
+holder_func (void *aux UNUSED) 
+{
+  holder = thread_current ();
+  lock_acquire (&lock);
+  sema_down (&release);
+  lock_release (&lock);
+  msg ("Holder should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  sema_up (&done);
+}
+
+static void
+waiter_func (void *w_) 
+{
+  struct waiter *w = w_;
+
+  lock_acquire (&lock);
+  order[order_cnt++] = w;
+  lock_release (&lock);
+}
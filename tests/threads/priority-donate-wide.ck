@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-wide) begin
+(priority-donate-wide) Holder should have priority 63.  Actual priority: 63.
+(priority-donate-wide) Holder should have priority 32.  Actual priority: 32.
+(priority-donate-wide) All 200 waiters got the lock in order.
+(priority-donate-wide) end
+EOF
+pass;
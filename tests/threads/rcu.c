@@ -0,0 +1,202 @@
+/* Measures the cost of looking up a key in a short list under
+   RCU, next to the same lookup under a reader-writer lock, which
+   is how the open inode table used to be read.
+
+   Then checks that RCU works: reader threads walk the list
+   without any lock, while the main thread keeps replacing its
+   elements and frees each old one, after poisoning it, with
+   call_rcu().  The readers run at a lower priority, so the
+   writer preempts them in the middle of their walks each time it
+   wakes up, and grace periods must wait for them.  No reader may
+   ever see a poisoned element, and every callback must run. */
+
+#include <stdio.h>
+#include <list.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/rcu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ITEM_CNT 32             /* Elements in the list. */
+#define ITER_CNT 100000         /* Lookups timed per method. */
+#define READER_CNT 3            /* Reader threads. */
+#define ROUND_CNT 200           /* Replacements by the writer. */
+#define ITEM_MAGIC 0x7263755f   /* Live element. */
+
+struct item
+  {
+    struct list_elem elem;
+    struct rcu_head rcu;
+    int key;
+    int magic;                  /* ITEM_MAGIC, or 0 once freed. */
+  };
+
+static struct list items;
+static struct lock items_lock;  /* Serializes writers. */
+static struct rwlock items_rw;  /* For comparison only. */
+
+static volatile bool stop;
+static volatile bool bad;
+static volatile int freed_cnt;
+static struct lock freed_lock;  /* Protects freed_cnt. */
+static struct semaphore readers_done;
+
+static struct item *new_item (int key);
+static struct item *find (int key);
+static thread_func reader;
+static rcu_func poison_free;
+
+void
+test_rcu (void)
+{
+  uint64_t start, rw_cycles, rcu_cycles;
+  int64_t gp_start;
+  int queued_cnt = 0;
+  int i;
+
+  list_init (&items);
+  lock_init (&items_lock);
+  lock_init (&freed_lock);
+  rw_init (&items_rw);
+  for (i = 0; i < ITEM_CNT; i++)
+    list_push_back_rcu (&items, &new_item (i)->elem);
+
+  /* Time lookups. */
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      rw_read_acquire (&items_rw);
+      if (find (i % ITEM_CNT) == NULL)
+        fail ("key %d not found", i % ITEM_CNT);
+      rw_read_release (&items_rw);
+    }
+  rw_cycles = rdtsc () - start;
+
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      rcu_read_lock ();
+      if (find (i % ITEM_CNT) == NULL)
+        fail ("key %d not found", i % ITEM_CNT);
+      rcu_read_unlock ();
+    }
+  rcu_cycles = rdtsc () - start;
+
+  msg ("rwlock: %llu cycles per lookup.",
+       (unsigned long long) (rw_cycles / ITER_CNT));
+  msg ("rcu: %llu cycles per lookup.",
+       (unsigned long long) (rcu_cycles / ITER_CNT));
+
+  /* Replace elements under the readers' feet. */
+  gp_start = rcu_gp_seq;
+  stop = false;
+  sema_init (&readers_done, 0);
+  for (i = 0; i < READER_CNT; i++)
+    thread_create ("reader", PRI_DEFAULT - 1, reader, NULL);
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      struct item *old;
+
+      lock_acquire (&items_lock);
+      old = list_entry (list_front (&items), struct item, elem);
+      list_remove_rcu (&old->elem);
+      list_push_back_rcu (&items, &new_item (old->key)->elem);
+      lock_release (&items_lock);
+
+      call_rcu (&old->rcu, poison_free);
+      queued_cnt++;
+      if (i % 50 == 49)
+        synchronize_rcu ();
+      else
+        timer_sleep (1);
+    }
+
+  stop = true;
+  for (i = 0; i < READER_CNT; i++)
+    sema_down (&readers_done);
+  for (i = 0; i < TIMER_FREQ && freed_cnt < queued_cnt; i++)
+    timer_sleep (1);
+
+  if (bad)
+    fail ("a reader saw a freed element");
+  if (freed_cnt != queued_cnt)
+    fail ("%d of %d callbacks ran", freed_cnt, queued_cnt);
+  if (rcu_gp_seq == gp_start)
+    fail ("no grace period started");
+  msg ("Readers saw no freed elements.");
+
+  while (!list_empty (&items))
+    free (list_entry (list_pop_front (&items), struct item, elem));
+  pass ();
+}
+
+static struct item *
+new_item (int key)
+{
+  struct item *it = malloc (sizeof *it);
+  if (it == NULL)
+    fail ("out of memory");
+  it->key = key;
+  it->magic = ITEM_MAGIC;
+  return it;
+}
+
+/* Returns the element with KEY, or a null pointer. */
+static struct item *
+find (int key)
+{
+  struct list_elem *e;
+
+  for (e = list_begin_rcu (&items); e != list_end (&items);
+       e = list_next_rcu (e))
+    {
+      struct item *it = list_entry (e, struct item, elem);
+      if (it->key == key)
+        return it;
+    }
+  return NULL;
+}
+
+/* Walks the list, many times per read-side critical section,
+   checking every element, until told to stop. */
+static void
+reader (void *aux UNUSED)
+{
+  while (!stop)
+    {
+      int pass;
+
+      rcu_read_lock ();
+      for (pass = 0; pass < 64; pass++)
+        {
+          struct list_elem *e;
+
+          for (e = list_begin_rcu (&items); e != list_end (&items);
+               e = list_next_rcu (e))
+            if (list_entry (e, struct item, elem)->magic != ITEM_MAGIC)
+              bad = true;
+        }
+      rcu_read_unlock ();
+    }
+  sema_up (&readers_done);
+}
+
+/* rcu_func that poisons and frees an element. */
+static void
+poison_free (struct rcu_head *head)
+{
+  struct item *it = rcu_entry (head, struct item, rcu);
+
+  it->magic = 0;
+  free (it);
+
+  /* Callbacks may run in more than one worker at once. */
+  lock_acquire (&freed_lock);
+  freed_cnt++;
+  lock_release (&freed_lock);
+}
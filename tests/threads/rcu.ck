@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timings depend on the host, so only check that they were
+# measured and that the test passed.
+fail "Reader-writer lock timing was not reported.\n"
+  if !grep (/^\(rcu\) rwlock: \d+ cycles per lookup\.$/, @output);
+fail "RCU timing was not reported.\n"
+  if !grep (/^\(rcu\) rcu: \d+ cycles per lookup\.$/, @output);
+fail "Test did not pass.\n" if !grep (/^\(rcu\) PASS$/, @output);
+pass;
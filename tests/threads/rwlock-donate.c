@@ -0,0 +1,73 @@
+/* The main thread takes a reader-writer lock for reading, checks
+   that it can upgrade and downgrade it, and keeps it.  A second
+   reader then gets it at the same time.  A writer that comes
+   next has to wait, and donates its priority to the main thread.
+   A reader that comes after the writer has to wait too, behind
+   the writer, even though the lock is only held for reading.
+   Once the main thread releases the lock, the writer gets it,
+   then the waiting reader. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_func;
+static thread_func writer_func;
+
+void
+test_rwlock_donate (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rw);
+  rw_read_acquire (&rw);
+  if (!rw_upgrade (&rw))
+    fail ("sole reader could not upgrade");
+  rw_downgrade (&rw);
+  msg ("Main upgraded its read lock and downgraded it again.");
+
+  thread_create ("reader 1", PRI_DEFAULT + 1, reader_func, &rw);
+  thread_create ("writer", PRI_DEFAULT + 2, writer_func, &rw);
+  msg ("Main should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+
+  /* Same priority as ours, so let it run. */
+  thread_create ("reader 2", PRI_DEFAULT + 2, reader_func, &rw);
+  thread_yield ();
+  msg ("Reader 2 is waiting behind the writer.");
+
+  msg ("Main releasing read lock.");
+  rw_read_release (&rw);
+  msg ("Main should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+reader_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_read_acquire (rw);
+  msg ("%s acquired read lock.", thread_name ());
+  rw_read_release (rw);
+  msg ("%s finished.", thread_name ());
+}
+
+static void
+writer_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_write_acquire (rw);
+  msg ("Writer acquired write lock.");
+  rw_write_release (rw);
+  msg ("Writer finished.");
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate) begin
+(rwlock-donate) Main upgraded its read lock and downgraded it again.
+(rwlock-donate) reader 1 acquired read lock.
+(rwlock-donate) reader 1 finished.
+(rwlock-donate) Main should have priority 33.  Actual priority: 33.
+(rwlock-donate) Reader 2 is waiting behind the writer.
+(rwlock-donate) Main releasing read lock.
+(rwlock-donate) Writer acquired write lock.
+(rwlock-donate) Writer finished.
+(rwlock-donate) reader 2 acquired read lock.
+(rwlock-donate) reader 2 finished.
+(rwlock-donate) Main should have priority 31.  Actual priority: 31.
+(rwlock-donate) end
+EOF
+pass;
@@ -0,0 +1,112 @@
+/* Checks and measures the object caches.
+
+   Creates a cache of cache-line-aligned objects with a
+   constructor, allocates many of them, and checks that each one
+   is aligned, constructed, and does not overlap any other.  Then
+   checks that an object freed in its constructed state is handed
+   out again without being constructed again, times allocation
+   against malloc(), and prints the caches' memory use. */
+
+#include <stdio.h>
+#include <string.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/slab.h"
+
+#define OBJ_CNT 500             /* Objects live at once. */
+#define TIME_CNT 10000          /* Timed alloc/free pairs. */
+#define OBJ_MAGIC 0x0b1ec7      /* Marks a constructed object. */
+
+struct object
+  {
+    int magic;                  /* OBJ_MAGIC when constructed. */
+    int owner;                  /* Index in objs[] while in use. */
+    char data[184];
+  };
+
+static struct object *objs[OBJ_CNT];
+static int ctor_cnt;
+
+static void
+construct (void *obj_)
+{
+  struct object *obj = obj_;
+
+  obj->magic = OBJ_MAGIC;
+  obj->owner = -1;
+  ctor_cnt++;
+}
+
+void
+test_slab (void)
+{
+  struct kmem_cache *cache;
+  uint64_t start, slab_cycles, malloc_cycles;
+  int before;
+  int i;
+
+  cache = kmem_cache_create ("slab-test", sizeof (struct object), 64,
+                             construct);
+
+  /* Correctness. */
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      struct object *obj = objs[i] = kmem_cache_alloc (cache);
+      if (obj == NULL)
+        fail ("out of memory after %d objects", i);
+      if ((uintptr_t) obj % 64 != 0)
+        fail ("object %p is not aligned", obj);
+      if (obj->magic != OBJ_MAGIC || obj->owner != -1)
+        fail ("object %p is not constructed", obj);
+      obj->owner = i;
+      memset (obj->data, i, sizeof obj->data);
+    }
+  for (i = 0; i < OBJ_CNT; i++)
+    if (objs[i]->owner != i
+        || objs[i]->data[0] != (char) i
+        || objs[i]->data[sizeof objs[i]->data - 1] != (char) i)
+      fail ("object %d was overwritten", i);
+  msg ("%d objects allocated, %d constructed.", OBJ_CNT, ctor_cnt);
+  kmem_print_stats ();
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i]->owner = -1;
+      kmem_cache_free (cache, objs[i]);
+    }
+
+  /* Reuse must not construct again. */
+  before = ctor_cnt;
+  for (i = 0; i < TIME_CNT; i++)
+    {
+      struct object *obj = kmem_cache_alloc (cache);
+      if (obj->magic != OBJ_MAGIC || obj->owner != -1)
+        fail ("reused object %p is not constructed", obj);
+      kmem_cache_free (cache, obj);
+    }
+  if (ctor_cnt != before)
+    fail ("%d objects were constructed again", ctor_cnt - before);
+  msg ("Freed objects were reused without construction.");
+
+  /* Throughput. */
+  start = rdtsc ();
+  for (i = 0; i < TIME_CNT; i++)
+    kmem_cache_free (cache, kmem_cache_alloc (cache));
+  slab_cycles = rdtsc () - start;
+
+  start = rdtsc ();
+  for (i = 0; i < TIME_CNT; i++)
+    {
+      struct object *obj = malloc (sizeof *obj);
+      construct (obj);
+      free (obj);
+    }
+  malloc_cycles = rdtsc () - start;
+
+  msg ("slab: %llu cycles per alloc/free pair.",
+       (unsigned long long) (slab_cycles / TIME_CNT));
+  msg ("malloc: %llu cycles per alloc/free pair.",
+       (unsigned long long) (malloc_cycles / TIME_CNT));
+  pass ();
+}
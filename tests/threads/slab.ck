@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# How many objects fit in a slab, and the timings, depend on the
+# build and the host, so only check that they were reported and
+# that the test passed.
+fail "Objects were not allocated.\n"
+  if !grep (/^\(slab\) 500 objects allocated, \d+ constructed\.$/, @output);
+fail "Cache statistics were not printed.\n"
+  if !grep (/^Slab: slab-test: \d+-byte objects, \d+ per slab, 500 in use/,
+	    @output);
+fail "Slab timing was not reported.\n"
+  if !grep (/^\(slab\) slab: \d+ cycles per alloc\/free pair\.$/, @output);
+fail "Malloc timing was not reported.\n"
+  if !grep (/^\(slab\) malloc: \d+ cycles per alloc\/free pair\.$/, @output);
+fail "Test did not pass.\n" if !grep (/^\(slab\) PASS$/, @output);
+pass;
@@ -0,0 +1,94 @@
+/* Runs CPU-bound threads for a fixed time and reports how much
+   work they got done, so that runs with different numbers of
+   CPUs can be compared, e.g.:
+
+     pintos -smp 1 -- -q run smp-scale
+     pintos -smp 4 -- -q run smp-scale
+
+   This is a benchmark rather than a test of scaling: throughput
+   should grow with the number of CPUs, up to the number of
+   worker threads, but one run cannot tell whether it did.  The
+   test only fails if some worker never gets to run. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define WORKER_CNT 8
+#define RUN_TICKS (2 * TIMER_FREQ)
+
+/* Iterations of busy work per work unit. */
+#define UNIT_LOOPS 10000
+
+struct worker
+  {
+    int64_t units;                      /* Work units completed. */
+    struct semaphore done;              /* Upped when the worker exits. */
+  } __attribute__ ((aligned (64)));     /* Own cache line. */
+
+static struct worker workers[WORKER_CNT];
+static volatile bool stop;
+
+static thread_func worker_thread;
+
+void
+test_smp_scale (void)
+{
+  int64_t start, elapsed, total;
+  int i;
+
+  msg ("Running %d CPU-bound threads on %d CPU(s).", WORKER_CNT, cpu_cnt);
+
+  /* Make sure we get to stop the workers on time. */
+  thread_set_priority (PRI_DEFAULT + 1);
+
+  stop = false;
+  start = timer_ticks ();
+  for (i = 0; i < WORKER_CNT; i++)
+    {
+      char name[16];
+
+      workers[i].units = 0;
+      sema_init (&workers[i].done, 0);
+      snprintf (name, sizeof name, "worker %d", i);
+      thread_create (name, PRI_DEFAULT, worker_thread, &workers[i]);
+    }
+
+  timer_sleep (RUN_TICKS);
+  stop = true;
+  elapsed = timer_elapsed (start);
+
+  total = 0;
+  for (i = 0; i < WORKER_CNT; i++)
+    {
+      sema_down (&workers[i].done);
+      if (workers[i].units == 0)
+        fail ("worker %d never ran", i);
+      total += workers[i].units;
+    }
+
+  msg ("%d CPU(s): %lld work units per second.",
+       cpu_cnt, total * TIMER_FREQ / elapsed);
+  pass ();
+}
+
+/* Does units of busy work until told to stop. */
+static void
+worker_thread (void *w_)
+{
+  struct worker *w = w_;
+
+  while (!stop)
+    {
+      volatile unsigned x = 0;
+      int i;
+
+      for (i = 0; i < UNIT_LOOPS; i++)
+        x = x * 1103515245 + 12345;
+      w->units++;
+    }
+  sema_up (&w->done);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# A benchmark: throughput depends on the host and on the number
+# of CPUs, and is only meaningful next to runs with other -smp
+# values, so only check that it was measured and that every
+# worker ran.
+fail "Throughput was not reported.\n"
+  if !grep (/^\(smp-scale\) \d+ CPU\(s\): \d+ work units per second\.$/,
+	    @output);
+fail "Test did not pass.\n" if !grep (/^\(smp-scale\) PASS$/, @output);
+pass;
@@ -0,0 +1,94 @@
+/* Bounces control between two threads through a pair of
+   semaphores and measures the cost of a thread switch, first
+   with switch_context(), which saves only the callee-saved
+   registers, then with the full interrupt frame and iretq that
+   Pintos switched threads with before.
+
+   Each round trip is two switches.  Timings depend on the host,
+   so the test only checks that every handoff arrived, in order,
+   in both modes. */
+
+#include <stdio.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ROUND_CNT 20000
+
+struct pingpong
+  {
+    struct semaphore ping;      /* Upped by the main thread. */
+    struct semaphore pong;      /* Upped by the partner. */
+    int rounds;                 /* Round trips seen by the partner. */
+  };
+
+static thread_func partner_thread;
+static uint64_t measure (bool iret);
+
+void
+test_switch_pingpong (void)
+{
+  uint64_t ctx_cycles, iret_cycles;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  ctx_cycles = measure (false);
+  iret_cycles = measure (true);
+
+  msg ("switch_context: %llu cycles per switch.",
+       (unsigned long long) (ctx_cycles / (2 * ROUND_CNT)));
+  msg ("iretq: %llu cycles per switch.",
+       (unsigned long long) (iret_cycles / (2 * ROUND_CNT)));
+  pass ();
+}
+
+/* Runs ROUND_CNT round trips with the partner thread, switching
+   through the interrupt frame if IRET is true, and returns the
+   cycles they took. */
+static uint64_t
+measure (bool iret)
+{
+  struct pingpong pp;
+  uint64_t start, cycles;
+  int i;
+
+  sema_init (&pp.ping, 0);
+  sema_init (&pp.pong, 0);
+  pp.rounds = 0;
+  thread_switch_iret = iret;
+  thread_create ("partner", PRI_DEFAULT, partner_thread, &pp);
+
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      sema_up (&pp.ping);
+      sema_down (&pp.pong);
+      if (pp.rounds != i + 1)
+        fail ("partner saw %d rounds, expected %d", pp.rounds, i + 1);
+    }
+  cycles = rdtsc () - start;
+  thread_switch_iret = false;
+
+  /* Let the partner exit. */
+  sema_up (&pp.ping);
+  sema_down (&pp.pong);
+  return cycles;
+}
+
+static void
+partner_thread (void *pp_)
+{
+  struct pingpong *pp = pp_;
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      sema_down (&pp->ping);
+      pp->rounds++;
+      sema_up (&pp->pong);
+    }
+  sema_down (&pp->ping);
+  sema_up (&pp->pong);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timings depend on the host, so only check that they were
+# measured and that the test passed.
+fail "switch_context() timing was not reported.\n"
+  if !grep (/^\(switch-pingpong\) switch_context: \d+ cycles per switch\.$/,
+	    @output);
+fail "iretq timing was not reported.\n"
+  if !grep (/^\(switch-pingpong\) iretq: \d+ cycles per switch\.$/, @output);
+fail "Test did not pass.\n" if !grep (/^\(switch-pingpong\) PASS$/, @output);
+pass;
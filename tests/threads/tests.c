@@ -17,6 +17,28 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-wheel", test_alarm_wheel},
+    {"alarm-nohz", test_alarm_nohz},
+    {"smp-scale", test_smp_scale},
+    {"lock-fast", test_lock_fast},
+    {"rwlock-donate", test_rwlock_donate},
+    {"priority-donate-wide", test_priority_donate_wide},
+    {"priority-donate-condvar", test_priority_donate_condvar},
+    {"switch-pingpong", test_switch_pingpong},
+    {"thread-create-cache", test_thread_create_cache},
+    {"workqueue", test_workqueue},
+    {"edf-admit", test_edf_admit},
+    {"edf-load", test_edf_load},
+    {"edf-wakeup", test_edf_wakeup},
+    {"futex", test_futex},
+    {"thread-stats", test_thread_stats},
+    {"ktimer", test_ktimer},
+    {"alarm-slack", test_alarm_slack},
+    {"rcu", test_rcu},
+    {"palloc-buddy", test_palloc_buddy},
+    {"slab", test_slab},
+    {"vmalloc", test_vmalloc},
+    {"palloc-prezero", test_palloc_prezero},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -38,6 +60,8 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"mlfqs-tick-cost", test_mlfqs_tick_cost},
+    {"mlfqs-ready-cost", test_mlfqs_ready_cost},
   };
 
 static const char *test_name;
@@ -11,6 +11,28 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_wheel;
+extern test_func test_alarm_nohz;
+extern test_func test_smp_scale;
+extern test_func test_lock_fast;
+extern test_func test_rwlock_donate;
+extern test_func test_priority_donate_wide;
+extern test_func test_priority_donate_condvar;
+extern test_func test_switch_pingpong;
+extern test_func test_thread_create_cache;
+extern test_func test_workqueue;
+extern test_func test_edf_admit;
+extern test_func test_edf_load;
+extern test_func test_edf_wakeup;
+extern test_func test_futex;
+extern test_func test_thread_stats;
+extern test_func test_ktimer;
+extern test_func test_alarm_slack;
+extern test_func test_rcu;
+extern test_func test_palloc_buddy;
+extern test_func test_slab;
+extern test_func test_vmalloc;
+extern test_func test_palloc_prezero;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -32,6 +54,8 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_mlfqs_tick_cost;
+extern test_func test_mlfqs_ready_cost;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,69 @@
+/* Measures the latency of creating a thread that runs and exits
+   at once, first reusing the pages of dead threads, then with
+   the thread cache disabled so that every thread gets a fresh
+   page from palloc, zeroed, as thread_create() used to do.
+
+   Timings depend on the host, so the test only checks that
+   every thread ran, in both modes. */
+
+#include <stdio.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/thread.h"
+
+#define THREAD_CNT 2000
+
+static thread_func quick_thread;
+static uint64_t measure (bool disable_cache);
+
+static int ran_cnt;
+
+void
+test_thread_create_cache (void)
+{
+  uint64_t cache_cycles, palloc_cycles;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  cache_cycles = measure (false);
+  palloc_cycles = measure (true);
+
+  msg ("cached: %llu cycles per thread.",
+       (unsigned long long) (cache_cycles / THREAD_CNT));
+  msg ("palloc: %llu cycles per thread.",
+       (unsigned long long) (palloc_cycles / THREAD_CNT));
+  pass ();
+}
+
+/* Creates THREAD_CNT threads, one at a time, and returns the
+   cycles it took for all of them to run. */
+static uint64_t
+measure (bool disable_cache)
+{
+  uint64_t start, cycles;
+  int i;
+
+  ran_cnt = 0;
+  thread_cache_disabled = disable_cache;
+  start = rdtsc ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      /* Higher priority, so the new thread runs to completion
+         before thread_create() returns. */
+      if (thread_create ("quick", PRI_DEFAULT + 1, quick_thread, NULL)
+          == TID_ERROR)
+        fail ("thread_create() failed");
+      if (ran_cnt != i + 1)
+        fail ("%d threads ran, expected %d", ran_cnt, i + 1);
+    }
+  cycles = rdtsc () - start;
+  thread_cache_disabled = false;
+  return cycles;
+}
+
+static void
+quick_thread (void *aux UNUSED)
+{
+  ran_cnt++;
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timings depend on the host, so only check that they were
+# measured and that the test passed.
+fail "Cached timing was not reported.\n"
+  if !grep (/^\(thread-create-cache\) cached: \d+ cycles per thread\.$/,
+	    @output);
+fail "palloc timing was not reported.\n"
+  if !grep (/^\(thread-create-cache\) palloc: \d+ cycles per thread\.$/,
+	    @output);
+fail "Test did not pass.\n"
+  if !grep (/^\(thread-create-cache\) PASS$/, @output);
+pass;
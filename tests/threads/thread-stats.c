@@ -0,0 +1,72 @@
+/* Checks the CPU accounting that thread_get_stats() returns for
+   a kernel thread: busy work adds kernel cycles and no user
+   cycles, sleeping counts as a voluntary switch, and yielding to
+   another thread counts as an involuntary switch and records the
+   wait in the run queue histogram.  Cycle counts depend on the
+   host, so only their direction is checked. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func yield_thread;
+static volatile int spin;
+
+static uint64_t hist_total (const struct thread_stats *);
+
+void
+test_thread_stats (void) 
+{
+  struct thread_stats before, after;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  thread_get_stats (&before);
+  for (i = 0; i < 1000000; i++)
+    spin = i;
+  thread_get_stats (&after);
+  if (after.kernel_cycles <= before.kernel_cycles)
+    fail ("kernel cycles did not go up");
+  if (after.user_cycles != before.user_cycles)
+    fail ("a kernel thread gained user cycles");
+  msg ("Busy work added kernel cycles only.");
+
+  before = after;
+  timer_sleep (1);
+  thread_get_stats (&after);
+  if (after.voluntary_switches <= before.voluntary_switches)
+    fail ("sleeping was not counted as a voluntary switch");
+  msg ("Sleeping counted as a voluntary switch.");
+
+  before = after;
+  thread_create ("yield", PRI_DEFAULT, yield_thread, NULL);
+  thread_yield ();
+  thread_get_stats (&after);
+  if (after.involuntary_switches <= before.involuntary_switches)
+    fail ("yielding was not counted as an involuntary switch");
+  if (hist_total (&after) <= hist_total (&before))
+    fail ("the run queue wait was not recorded");
+  msg ("Yielding counted as an involuntary switch.");
+}
+
+static void
+yield_thread (void *aux UNUSED) 
+{
+  msg ("Other thread ran.");
+}
+
+/* Returns the number of waits in STATS's run queue histogram. */
+static uint64_t
+hist_total (const struct thread_stats *stats) 
+{
+  uint64_t total = 0;
+  int b;
+
+  for (b = 0; b < THREAD_STATS_BUCKETS; b++)
+    total += stats->rq_wait_hist[b];
+  return total;
+}
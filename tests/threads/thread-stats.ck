@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-stats) begin
+(thread-stats) Busy work added kernel cycles only.
+(thread-stats) Sleeping counted as a voluntary switch.
+(thread-stats) Other thread ran.
+(thread-stats) Yielding counted as an involuntary switch.
+(thread-stats) end
+EOF
+pass;
@@ -0,0 +1,137 @@
+/* Checks that large tables from kvmalloc() survive a fragmented
+   page pool.
+
+   Takes every page in the kernel pool, then gives back only the
+   pages at odd page numbers, so that no two free pages are
+   adjacent.  A physically contiguous multi-page block then
+   cannot be had, from palloc or from malloc(), but kvmalloc() of
+   the same size must still succeed, through vmalloc(), and the
+   block must hold its contents.  Finally allocates and frees
+   enough blocks with vmalloc() to wrap around its range several
+   times, which forces stale pages to be purged and reused.
+   vmalloc() fails rather than wait for other CPUs to flush their
+   TLBs, so a failed allocation is retried a tick later. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "threads/vmalloc.h"
+#include "devices/timer.h"
+
+#define BLOCK_PAGES 16          /* Size of the large blocks. */
+#define BLOCK_SIZE (BLOCK_PAGES * PGSIZE - 64)
+
+static void fill (uint8_t *, size_t, int seed);
+static void check (const uint8_t *, size_t, int seed);
+
+void
+test_vmalloc (void)
+{
+  void *held = NULL, *odd = NULL;
+  size_t held_cnt = 0, freed_cnt = 0;
+  uint8_t *a, *b;
+  int wrap_cnt, retry_cnt, i;
+
+  /* Fragment the kernel pool. */
+  for (;;)
+    {
+      void **page = palloc_get_page (0);
+      if (page == NULL)
+        break;
+      if (pg_no (page) % 2)
+        {
+          *page = odd;
+          odd = page;
+        }
+      else
+        {
+          *page = held;
+          held = page;
+          held_cnt++;
+        }
+    }
+  while (odd != NULL)
+    {
+      void *next = *(void **) odd;
+      palloc_free_page (odd);
+      odd = next;
+      freed_cnt++;
+    }
+  msg ("Holding %zu pages, %zu free pages are not adjacent.",
+       held_cnt, freed_cnt);
+
+  a = palloc_get_multiple (0, BLOCK_PAGES);
+  if (a != NULL)
+    fail ("pool is not fragmented: got %d contiguous pages", BLOCK_PAGES);
+  msg ("palloc_get_multiple() of %d pages failed.", BLOCK_PAGES);
+
+  a = malloc (BLOCK_SIZE);
+  if (a != NULL)
+    fail ("malloc() of %d bytes succeeded in a fragmented pool",
+          BLOCK_SIZE);
+  msg ("malloc() of %d bytes failed.", BLOCK_SIZE);
+
+  a = kvmalloc (BLOCK_SIZE);
+  b = kvmalloc (BLOCK_SIZE);
+  if (a == NULL || b == NULL)
+    fail ("kvmalloc() of %d bytes failed", BLOCK_SIZE);
+  if (!is_vmalloc_vaddr (a) || !is_vmalloc_vaddr (b))
+    fail ("large blocks did not come from vmalloc()");
+  fill (a, BLOCK_SIZE, 1);
+  fill (b, BLOCK_SIZE, 2);
+  check (a, BLOCK_SIZE, 1);
+  check (b, BLOCK_SIZE, 2);
+  kvfree (a);
+  kvfree (b);
+  msg ("kvmalloc() of %d bytes succeeded.", BLOCK_SIZE);
+
+  while (held != NULL)
+    {
+      void *next = *(void **) held;
+      palloc_free_page (held);
+      held = next;
+    }
+
+  /* Wrap around the range. */
+  wrap_cnt = 3 * VMALLOC_PAGES / (BLOCK_PAGES + 1);
+  for (i = 0; i < wrap_cnt; i++)
+    {
+      for (retry_cnt = 0; (a = vmalloc (BLOCK_SIZE)) == NULL; retry_cnt++)
+        {
+          if (retry_cnt >= TIMER_FREQ)
+            fail ("vmalloc() failed after %d blocks", i);
+          timer_sleep (1);
+        }
+      a[0] = i;
+      a[BLOCK_SIZE - 1] = i;
+      if (a[0] != (uint8_t) i || a[BLOCK_SIZE - 1] != (uint8_t) i)
+        fail ("block %d does not hold its contents", i);
+      vfree (a);
+    }
+  msg ("Allocated and freed %d blocks.", wrap_cnt);
+  pass ();
+}
+
+/* Fills the SIZE bytes at P with a pattern derived from SEED. */
+static void
+fill (uint8_t *p, size_t size, int seed)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    p[i] = i * seed + (i >> 12);
+}
+
+/* Checks the SIZE bytes at P against fill()'s pattern. */
+static void
+check (const uint8_t *p, size_t size, int seed)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (p[i] != (uint8_t) (i * seed + (i >> 12)))
+      fail ("byte %zu of block %d is wrong", i, seed);
+}
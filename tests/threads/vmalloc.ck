@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The number of pages depends on the memory size, so only check
+# that each step was reported and that the test passed.
+fail "Pool was not fragmented.\n"
+  if !grep (/^\(vmalloc\) Holding \d+ pages, \d+ free pages are not adjacent\.$/,
+	    @output);
+fail "Contiguous allocation did not fail.\n"
+  if !grep (/^\(vmalloc\) palloc_get_multiple\(\) of 16 pages failed\.$/,
+	    @output);
+fail "Large malloc() did not fail.\n"
+  if !grep (/^\(vmalloc\) malloc\(\) of \d+ bytes failed\.$/, @output);
+fail "Large kvmalloc() did not succeed.\n"
+  if !grep (/^\(vmalloc\) kvmalloc\(\) of \d+ bytes succeeded\.$/, @output);
+fail "Blocks were not reused.\n"
+  if !grep (/^\(vmalloc\) Allocated and freed \d+ blocks\.$/, @output);
+fail "Test did not pass.\n" if !grep (/^\(vmalloc\) PASS$/, @output);
+pass;
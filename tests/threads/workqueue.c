@@ -0,0 +1,84 @@
+/* Checks that queued work runs in a worker thread, ahead of the
+   thread that queued it, that queueing pending work again does
+   not run it twice, and that delayed work runs only after its
+   delay, in order of expiry. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+struct delayed
+  {
+    struct work work;
+    int64_t delay;              /* Ticks it was delayed by. */
+    int64_t queued;             /* Tick at which it was queued. */
+  };
+
+static work_func count_work, delayed_work;
+
+static int run_cnt;
+static struct semaphore done;
+
+void
+test_workqueue (void)
+{
+  struct work w;
+  struct delayed d[3];
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+
+  work_init (&w, count_work, NULL);
+  if (!queue_work (&w))
+    fail ("queue_work() of idle work failed");
+  msg ("Work ran %d time(s).", run_cnt);
+
+  /* Queue the same work twice while the workers cannot run. */
+  thread_set_priority (PRI_MAX);
+  queue_work (&w);
+  if (queue_work (&w))
+    fail ("pending work was queued twice");
+  thread_set_priority (PRI_DEFAULT);
+  msg ("Work ran %d time(s).", run_cnt);
+
+  /* Delayed work, queued out of order. */
+  for (i = 0; i < 3; i++)
+    {
+      d[i].delay = (3 - i) * 10;
+      work_init (&d[i].work, delayed_work, &d[i]);
+    }
+  for (i = 0; i < 3; i++)
+    {
+      d[i].queued = timer_ticks ();
+      queue_delayed_work (&d[i].work, d[i].delay);
+    }
+  for (i = 0; i < 3; i++)
+    sema_down (&done);
+}
+
+static void
+count_work (void *aux UNUSED)
+{
+  if (memcmp (thread_name (), "kworker", 7))
+    fail ("work ran in thread %s", thread_name ());
+  run_cnt++;
+}
+
+static void
+delayed_work (void *d_)
+{
+  struct delayed *d = d_;
+
+  if (timer_elapsed (d->queued) < d->delay)
+    fail ("work delayed by %lld ticks ran after %lld",
+          d->delay, timer_elapsed (d->queued));
+  msg ("Work delayed by %lld ticks ran.", d->delay);
+  sema_up (&done);
+}
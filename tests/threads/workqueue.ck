@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Work ran 1 time(s).
+(workqueue) Work ran 2 time(s).
+(workqueue) Work delayed by 10 ticks ran.
+(workqueue) Work delayed by 20 ticks ran.
+(workqueue) Work delayed by 30 ticks ran.
+(workqueue) end
+EOF
+pass;
@@ -0,0 +1,361 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Symmetric multiprocessing.
+
+   The bootstrap processor (BSP) runs everything up to and
+   including timer calibration alone.  smp_init() then starts the
+   application processors (APs) one at a time: each is sent an
+   INIT and two STARTUP inter-processor interrupts through the
+   local APIC, which make it execute the real-mode code in
+   ap-start.S, copied to physical address AP_TRAMPOLINE.  That code
+   switches to long mode on the boot page tables and calls
+   ap_main(), which turns the AP into the idle thread of its own
+   CPU.  From then on, the AP runs whatever threads it finds in its
+   run queue or steals from other CPUs.
+
+   The PIC still delivers every device interrupt, including the
+   8254 timer, to the BSP alone.  Each AP instead gets a periodic
+   tick from its local APIC timer, calibrated against the 8254.
+
+   See [IA32-v3a] chapter 10 "Advanced Programmable Interrupt
+   Controller (APIC)" and section 8.4 "Multiple-Processor (MP)
+   Initialization". */
+
+/* Per-CPU data.  cpus[0] is the BSP. */
+struct cpu cpus[CPU_MAX];
+
+/* Number of CPUs online.  CPUs come online in order, so these
+   are cpus[0] through cpus[cpu_cnt - 1]. */
+int cpu_cnt = 1;
+
+/* True once smp_init() has started bringing up APs.  Until then,
+   the BSP is the only CPU and cpu_current() need not look at the
+   running thread. */
+bool cpu_smp;
+
+/* Number of CPUs to use.
+   Controlled by kernel command-line option "-smp=N". */
+int smp_cpu_request = 1;
+
+/* Local APIC registers, as offsets from the APIC base. */
+#define LAPIC_ID 0x020          /* Local APIC ID. */
+#define LAPIC_TPR 0x080         /* Task priority. */
+#define LAPIC_EOI 0x0b0         /* End of interrupt. */
+#define LAPIC_SVR 0x0f0         /* Spurious interrupt vector. */
+#define LAPIC_ICR_LO 0x300      /* Interrupt command, low half. */
+#define LAPIC_ICR_HI 0x310      /* Interrupt command, high half. */
+#define LAPIC_LVT_TIMER 0x320   /* Local vector table: timer. */
+#define LAPIC_LVT_LINT0 0x350   /* Local vector table: LINT0 pin. */
+#define LAPIC_LVT_LINT1 0x360   /* Local vector table: LINT1 pin. */
+#define LAPIC_TIMER_INIT 0x380  /* Timer initial count. */
+#define LAPIC_TIMER_CUR 0x390   /* Timer current count. */
+#define LAPIC_TIMER_DIV 0x3e0   /* Timer divide configuration. */
+
+/* Register bits. */
+#define LAPIC_SVR_ENABLE 0x100          /* APIC software enable. */
+#define LAPIC_LVT_MASKED 0x10000        /* Interrupt masked. */
+#define LAPIC_LVT_EXTINT 0x700          /* Delivery mode: ExtINT. */
+#define LAPIC_LVT_NMI 0x400             /* Delivery mode: NMI. */
+#define LAPIC_TIMER_PERIODIC 0x20000    /* Timer mode: periodic. */
+#define LAPIC_TIMER_DIV16 0x3           /* Divide bus clock by 16. */
+#define LAPIC_ICR_INIT 0x4500           /* INIT IPI, asserted. */
+#define LAPIC_ICR_STARTUP 0x4600        /* STARTUP IPI, asserted. */
+#define LAPIC_ICR_FIXED 0x4000          /* Fixed IPI, asserted. */
+#define LAPIC_ICR_PENDING 0x1000        /* Delivery status: send pending. */
+
+/* IA32_APIC_BASE model-specific register. */
+#define MSR_APIC_BASE 0x1b
+#define MSR_APIC_BASE_ADDR 0xfffff000
+
+/* Kernel virtual address of the local APIC's registers.  Every
+   CPU's local APIC answers at the same physical address. */
+static volatile uint32_t *lapic;
+
+/* Local APIC timer counts per timer tick, set by
+   lapic_calibrate(). */
+static uint32_t lapic_counts_per_tick;
+
+/* Handed from the BSP to the AP being started.  ap-start.S loads
+   AP_BOOT_CR3 and AP_BOOT_STACK before calling ap_main(). */
+uint64_t ap_boot_cr3;
+uint64_t ap_boot_stack;
+
+/* Code in ap-start.S that is copied to AP_TRAMPOLINE. */
+extern const char ap_trampoline[], ap_trampoline_end[];
+
+static void start_ap (struct cpu *);
+static void lapic_map (void);
+static void lapic_init (bool bsp);
+static void lapic_calibrate (void);
+static void lapic_timer_start (void);
+static void lapic_send (uint8_t apic_id, uint32_t icr);
+static uint32_t lapic_read (int reg);
+static void lapic_write (int reg, uint32_t value);
+static intr_handler_func lapic_timer_interrupt;
+static intr_handler_func lapic_ipi_interrupt;
+
+/* Initializes C as CPU number ID with local APIC ID APIC_ID. */
+void
+cpu_init (struct cpu *c, int id, uint8_t apic_id) {
+	int pri;
+
+	ASSERT (c != NULL);
+
+	memset (c, 0, sizeof *c);
+	c->id = id;
+	c->apic_id = apic_id;
+	spin_init (&c->rq_lock);
+	for (pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		list_init (&c->ready_queues[pri]);
+	heap_init (&c->edf_ready, thread_deadline_less, NULL);
+}
+
+/* Returns the CPU that we are running on.
+
+   A thread only moves between CPUs inside schedule(), which
+   records the new CPU in the thread before switching to it, so
+   the running thread's `cpu' member is always right.  The
+   caller must still turn interrupts off if it needs the answer
+   to stay right. */
+struct cpu *
+cpu_current (void) {
+	struct thread *t;
+
+	if (!cpu_smp)
+		return &cpus[0];
+
+	/* Same as running_thread() in thread.c. */
+	t = pg_round_down (rrsp ());
+	ASSERT (t->cpu != NULL);
+	return t->cpu;
+}
+
+/* Sends a wake-up interrupt to one idle CPU other than the
+   current one, if there is any, so that it can steal a thread
+   that was just made ready.  Must be called with interrupts
+   off. */
+void
+cpu_kick_idle (void) {
+	struct cpu *self = cpu_current ();
+	int i;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (i = 0; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[i];
+		if (c != self && c->curr == c->idle_thread) {
+			cpu_resched (c);
+			return;
+		}
+	}
+}
+
+/* Sends C, which must not be the current CPU, an interrupt that
+   makes it check whether its running thread should give way to
+   a higher-priority thread just made ready there.  Must be
+   called with interrupts off. */
+void
+cpu_resched (struct cpu *c) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (c != cpu_current ());
+
+	lapic_send (c->apic_id, LAPIC_ICR_FIXED | LAPIC_IPI_VEC);
+}
+
+/* Brings up the APs requested with -smp.  Must be called with
+   interrupts on, after timer_calibrate(). */
+void
+smp_init (void) {
+	int i;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	if (smp_cpu_request <= 1)
+		return;
+	if (smp_cpu_request > CPU_MAX)
+		smp_cpu_request = CPU_MAX;
+	if (timer_nohz) {
+		/* Only the BSP keeps `ticks' up to date. */
+		printf ("smp: tickless idle needs a single CPU; ignoring -nohz.\n");
+		timer_nohz = false;
+	}
+
+	lapic_map ();
+	lapic_init (true);
+	lapic_calibrate ();
+	intr_register_ext (LAPIC_TIMER_VEC, lapic_timer_interrupt, "LAPIC Timer");
+	intr_register_ext (LAPIC_IPI_VEC, lapic_ipi_interrupt, "LAPIC IPI");
+
+	memcpy (ptov (AP_TRAMPOLINE), ap_trampoline,
+			ap_trampoline_end - ap_trampoline);
+	ap_boot_cr3 = vtop (base_pml4);
+
+	/* From here on, cpu_current() looks at the running thread
+	   instead of assuming the BSP. */
+	cpu_smp = true;
+	barrier ();
+
+	for (i = 1; i < smp_cpu_request; i++) {
+		/* QEMU numbers local APICs 0, 1, 2, ... in CPU order. */
+		cpu_init (&cpus[i], i, i);
+		start_ap (&cpus[i]);
+		if (cpu_cnt != i + 1) {
+			printf ("smp: CPU %d did not start.\n", i);
+			break;
+		}
+	}
+	printf ("smp: %d CPUs online.\n", cpu_cnt);
+}
+
+/* Starts AP C and waits for it to come online, for up to a
+   tenth of a second. */
+static void
+start_ap (struct cpu *c) {
+	struct thread *t = thread_alloc_ap (c);
+	int64_t start;
+
+	if (t == NULL)
+		return;
+	ap_boot_stack = (uint64_t) t + PGSIZE;
+	barrier ();
+
+	/* INIT, then STARTUP twice, as the MP specification asks.
+	   The STARTUP vector is the page number of the trampoline. */
+	lapic_send (c->apic_id, LAPIC_ICR_INIT);
+	timer_msleep (10);
+	lapic_send (c->apic_id, LAPIC_ICR_STARTUP | (AP_TRAMPOLINE >> PGBITS));
+	timer_usleep (200);
+	lapic_send (c->apic_id, LAPIC_ICR_STARTUP | (AP_TRAMPOLINE >> PGBITS));
+
+	start = timer_ticks ();
+	while (cpu_cnt <= c->id && timer_elapsed (start) < TIMER_FREQ / 10)
+		barrier ();
+}
+
+/* Called by ap-start.S on a newly started AP, with interrupts
+   off, on the page tables in base_pml4 and the stack of the
+   thread allocated for it by start_ap(). */
+void
+ap_main (void) {
+	thread_init_ap ();
+	intr_init_ap ();
+	lapic_init (false);
+	lapic_timer_start ();
+
+	cpu_cnt++;
+	thread_start_ap ();
+}
+
+/* Acknowledges the interrupt being serviced by the local APIC. */
+void
+lapic_eoi (void) {
+	lapic_write (LAPIC_EOI, 0);
+}
+
+/* Maps the local APIC's registers into the kernel page table,
+   with caching disabled. */
+static void
+lapic_map (void) {
+	uint64_t base = read_msr (MSR_APIC_BASE) & MSR_APIC_BASE_ADDR;
+	uint64_t *pte = pml4e_walk (base_pml4, (uint64_t) ptov (base), 1);
+
+	ASSERT (pte != NULL);
+	*pte = base | PTE_P | PTE_W | PTE_PWT | PTE_PCD;
+	invlpg ((uint64_t) ptov (base));
+	lapic = ptov (base);
+}
+
+/* Enables the current CPU's local APIC.  On the BSP, the PIC
+   stays wired through LINT0; an AP must ignore it, or it would
+   see every device interrupt too. */
+static void
+lapic_init (bool bsp) {
+	lapic_write (LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+	lapic_write (LAPIC_TPR, 0);
+	lapic_write (LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+	lapic_write (LAPIC_LVT_LINT0, bsp ? LAPIC_LVT_EXTINT : LAPIC_LVT_MASKED);
+	lapic_write (LAPIC_LVT_LINT1, bsp ? LAPIC_LVT_NMI : LAPIC_LVT_MASKED);
+}
+
+/* Measures how many local APIC timer counts make up one timer
+   tick, by letting the timer count down for a few 8254 ticks. */
+static void
+lapic_calibrate (void) {
+	const int calibrate_ticks = 5;
+	int64_t start;
+
+	lapic_write (LAPIC_TIMER_DIV, LAPIC_TIMER_DIV16);
+
+	/* Wait for a tick boundary. */
+	start = timer_ticks ();
+	while (timer_ticks () == start)
+		barrier ();
+
+	start = timer_ticks ();
+	lapic_write (LAPIC_TIMER_INIT, UINT32_MAX);
+	while (timer_elapsed (start) < calibrate_ticks)
+		barrier ();
+	lapic_counts_per_tick =
+		(UINT32_MAX - lapic_read (LAPIC_TIMER_CUR)) / calibrate_ticks;
+	lapic_write (LAPIC_TIMER_INIT, 0);
+}
+
+/* Starts the current CPU's local APIC timer interrupting
+   TIMER_FREQ times per second. */
+static void
+lapic_timer_start (void) {
+	lapic_write (LAPIC_TIMER_DIV, LAPIC_TIMER_DIV16);
+	lapic_write (LAPIC_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VEC);
+	lapic_write (LAPIC_TIMER_INIT, lapic_counts_per_tick);
+}
+
+/* Sends the interprocessor interrupt described by ICR to the CPU
+   whose local APIC ID is APIC_ID, and waits until it has been
+   accepted. */
+static void
+lapic_send (uint8_t apic_id, uint32_t icr) {
+	lapic_write (LAPIC_ICR_HI, (uint32_t) apic_id << 24);
+	lapic_write (LAPIC_ICR_LO, icr);
+	while (lapic_read (LAPIC_ICR_LO) & LAPIC_ICR_PENDING)
+		asm volatile ("pause");
+}
+
+/* Returns local APIC register REG. */
+static uint32_t
+lapic_read (int reg) {
+	return lapic[reg / sizeof *lapic];
+}
+
+/* Sets local APIC register REG to VALUE. */
+static void
+lapic_write (int reg, uint32_t value) {
+	lapic[reg / sizeof *lapic] = value;
+	(void) lapic_read (LAPIC_ID);   /* Wait for the write to finish. */
+}
+
+/* Local APIC timer interrupt handler. */
+static void
+lapic_timer_interrupt (struct intr_frame *args UNUSED) {
+	thread_tick ();
+}
+
+/* Wake-up and reschedule interrupt handler.  An idle CPU looks
+   for work when the interrupt returns to the idle loop; a busy
+   one yields on return if a higher-priority thread was made
+   ready here. */
+static void
+lapic_ipi_interrupt (struct intr_frame *args UNUSED) {
+	preempt_priority ();
+}
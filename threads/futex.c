@@ -0,0 +1,144 @@
+#include "threads/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Fast user-space mutexes.
+
+   A futex is just an int in user memory.  User code changes it
+   with atomic instructions, and only calls into the kernel to
+   sleep when it finds the futex in a state that calls for
+   waiting, or to wake sleepers after changing it.  The kernel's
+   only job is to make "check the value, then sleep" atomic with
+   respect to futex_wake(), so that no wakeup is lost.
+
+   The system call translates the user address, so the functions
+   here take the futex's kernel virtual address.  Sleepers are
+   kept in a fixed table of buckets, hashed by the physical
+   address of the futex, so that processes that map the same page
+   at different addresses still meet in the same bucket. */
+
+/* Number of buckets.  Must be a power of 2. */
+#define FUTEX_BUCKET_CNT 64
+
+/* A thread sleeping on a futex.  Lives on the sleeper's stack. */
+struct futex_waiter {
+	struct list_elem elem;      /* Element in bucket. */
+	uint64_t paddr;             /* Physical address of futex. */
+	struct thread *thread;      /* Sleeping thread. */
+	bool woken;                 /* Set by futex_wake(). */
+};
+
+/* Sleepers in each bucket, in order of arrival.  Protected by
+   futex_lock, which a sleeper holds from checking the futex's
+   value until it blocks. */
+static struct list buckets[FUTEX_BUCKET_CNT];
+static struct spinlock futex_lock;
+
+static struct futex_waiter *futex_best_waiter (struct list *, uint64_t paddr);
+
+/* Initializes the futex table. */
+void
+futex_init (void) {
+	int i;
+
+	for (i = 0; i < FUTEX_BUCKET_CNT; i++)
+		list_init (&buckets[i]);
+	spin_init (&futex_lock);
+}
+
+/* Returns the bucket for the futex at physical address PADDR. */
+static struct list *
+futex_bucket (uint64_t paddr) {
+	return &buckets[hash_bytes (&paddr, sizeof paddr)
+		& (FUTEX_BUCKET_CNT - 1)];
+}
+
+/* If the futex at kernel address FUTEX still holds VAL, sleeps
+   until futex_wake() is called on it, then returns 0.  Returns
+   -1 at once if it holds some other value. */
+int
+futex_wait (int *futex, int val) {
+	struct futex_waiter w;
+	enum intr_level old_level;
+
+	ASSERT (is_kernel_vaddr (futex));
+	ASSERT ((uintptr_t) futex % sizeof *futex == 0);
+
+	/* Test the value under futex_lock, so that a futex_wake()
+	   cannot slip in between. */
+	old_level = intr_disable ();
+	spin_lock (&futex_lock);
+	if (*futex != val) {
+		spin_unlock (&futex_lock);
+		intr_set_level (old_level);
+		return -1;
+	}
+
+	w.paddr = vtop (futex);
+	w.thread = thread_current ();
+	w.woken = false;
+	list_push_back (futex_bucket (w.paddr), &w.elem);
+	while (!w.woken)
+		thread_block_locked (&futex_lock);
+	spin_unlock (&futex_lock);
+	intr_set_level (old_level);
+	return 0;
+}
+
+/* Wakes up to N threads sleeping on the futex at kernel address
+   FUTEX, highest priority first.  Returns the number woken. */
+int
+futex_wake (int *futex, int n) {
+	enum intr_level old_level;
+	struct list *bucket;
+	uint64_t paddr;
+	int woken = 0;
+
+	ASSERT (is_kernel_vaddr (futex));
+
+	paddr = vtop (futex);
+	bucket = futex_bucket (paddr);
+	old_level = intr_disable ();
+	spin_lock (&futex_lock);
+	while (woken < n) {
+		struct futex_waiter *w = futex_best_waiter (bucket, paddr);
+
+		if (w == NULL)
+			break;
+		list_remove (&w->elem);
+		w->woken = true;
+		thread_unblock (w->thread);
+		woken++;
+	}
+	spin_unlock (&futex_lock);
+	intr_set_level (old_level);
+	preempt_priority ();
+	return woken;
+}
+
+/* Returns the waiter in BUCKET on the futex at physical address
+   PADDR that should be woken next, or a null pointer if there is
+   none.  That is the one with the highest priority, and of those
+   the earliest to arrive.  Priorities are compared now, rather
+   than when each waiter went to sleep, because donation can raise
+   a waiter's priority while it sleeps. */
+static struct futex_waiter *
+futex_best_waiter (struct list *bucket, uint64_t paddr) {
+	struct futex_waiter *best = NULL;
+	struct list_elem *e;
+
+	for (e = list_begin (bucket); e != list_end (bucket); e = list_next (e)) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+		if (w->paddr == paddr
+				&& (best == NULL || w->thread->priority > best->thread->priority))
+			best = w;
+	}
+	return best;
+}
@@ -13,6 +13,8 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/cpu.h"
+#include "threads/futex.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -20,7 +22,13 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/rcu.h"
+#include "threads/schedtrace.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/vmalloc.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -49,6 +57,9 @@ static bool format_filesys;
 /* -q: Power off after kernel tasks complete? */
 bool power_off_when_done;
 
+/* -slabstat: Print object cache memory use at exit? */
+static bool slab_stats;
+
 bool thread_tests;
 
 static void bss_init (void);
@@ -86,6 +97,7 @@ main (void) {
 	mem_end = palloc_init ();
 	malloc_init ();
 	paging_init (mem_end);
+	vmalloc_init ();
 
 #ifdef USERPROG
 	tss_init ();
@@ -95,6 +107,9 @@ main (void) {
 	/* Initialize interrupt handlers. */
 	intr_init ();
 	timer_init ();
+	workqueue_init ();
+	rcu_init ();
+	futex_init ();
 	kbd_init ();
 	input_init ();
 #ifdef USERPROG
@@ -103,8 +118,10 @@ main (void) {
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	workqueue_start ();
 	serial_init_queue ();
 	timer_calibrate ();
+	smp_init ();
 
 #ifdef FILESYS
 	/* Initialize file system. */
@@ -221,6 +238,31 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-nohz"))
+			timer_nohz = true;
+		else if (!strcmp (name, "-prezero"))
+			palloc_prezero = true;
+		else if (!strcmp (name, "-sched-trace"))
+			sched_trace_enabled = true;
+		else if (!strcmp (name, "-thread-stats"))
+			thread_stats_on_exit = true;
+		else if (!strcmp (name, "-irqsoff"))
+			intr_irqsoff_trace = true;
+		else if (!strcmp (name, "-lockstat"))
+			lockstat_enabled = true;
+		else if (!strcmp (name, "-slabstat"))
+			slab_stats = true;
+		else if (!strcmp (name, "-smp")) {
+			smp_cpu_request = atoi (value);
+#ifdef USERPROG
+			/* User programs need a TSS and syscall entry state per
+			   CPU, which gdt.c, tss.c and syscall-entry.S do not
+			   have. */
+			if (smp_cpu_request > 1)
+				PANIC ("-smp=%d: user programs need a single CPU",
+				       smp_cpu_request);
+#endif
+		}
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
@@ -326,6 +368,14 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -nohz              Stop the timer tick while idle.\n"
+			"  -prezero           Keep pre-zeroed pages for PAL_ZERO.\n"
+			"  -sched-trace       Trace scheduler events, dump them at shutdown.\n"
+			"  -thread-stats      Print CPU accounting for each thread at exit.\n"
+			"  -irqsoff           Time interrupts-off sections, print the longest.\n"
+			"  -lockstat          Keep lock contention statistics, print at exit.\n"
+			"  -slabstat          Print object cache memory use at exit.\n"
+			"  -smp=N             Run on N CPUs.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -353,6 +403,7 @@ power_off (void) {
 static void
 print_stats (void) {
 	timer_print_stats ();
+	intr_print_stats ();
 	thread_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
@@ -362,4 +413,12 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+	if (intr_irqsoff_trace)
+		intr_irqsoff_print ();
+	if (lockstat_enabled)
+		lock_print_stats ();
+	if (slab_stats)
+		kmem_print_stats ();
+	if (sched_trace_enabled)
+		sched_trace_dump ();
 }
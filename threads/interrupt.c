@@ -3,9 +3,12 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
@@ -93,15 +96,63 @@ static intr_handler_func *intr_handlers[INTR_CNT];
 /* Names for each interrupt, for debugging purposes. */
 static const char *intr_names[INTR_CNT];
 
+/* Number of times each external interrupt was handled, and the
+   longest its handler took, in TSC cycles.  Handlers run with
+   interrupts off, so this bounds the interrupt latency they
+   cause.  The local APIC vectors fire on every CPU at once and
+   are counted without a lock, so their counts are approximate. */
+static long long intr_cnts[INTR_CNT];
+static uint64_t intr_max_cycles[INTR_CNT];
+
+/* Interrupts-off tracer.
+
+   When intr_irqsoff_trace is set, every stretch of time from
+   intr_disable() to the matching intr_enable(), or their
+   intr_set_level() equivalents, is timed with the time stamp
+   counter, and the longest ones are kept, one entry for each
+   pair of places that turned interrupts off and back on.  The
+   places are return addresses, so they name the caller of
+   intr_disable() or intr_set_level().  A stretch that ends in a
+   different thread than it started, across a thread switch, is
+   charged to the pair of callers on either side.  Interrupt
+   handlers, which run with interrupts off from entry to exit,
+   are timed by intr_handler() instead.
+
+   The table is shared by all CPUs, so it is updated under
+   irqsoff_lock. */
+#define IRQSOFF_CNT 64          /* Distinct sections kept. */
+#define IRQSOFF_TOP 10          /* Sections printed. */
+
+struct irqsoff {
+	void *off;                  /* Caller that turned interrupts off. */
+	void *on;                   /* Caller that turned them back on. */
+	uint64_t max_cycles;        /* Longest stretch. */
+	long long cnt;              /* Number of stretches. */
+};
+
+bool intr_irqsoff_trace;
+static struct irqsoff irqsoffs[IRQSOFF_CNT];
+static long long irqsoff_dropped;
+static struct spinlock irqsoff_lock;
+
+static enum intr_level do_enable (void *caller);
+static enum intr_level do_disable (void *caller);
+static void irqsoff_begin (void *caller);
+static void irqsoff_end (void *caller);
+
 /* External interrupts are those generated by devices outside the
    CPU, such as the timer.  External interrupts run with
    interrupts turned off, so they never nest, nor are they ever
    pre-empted.  Handlers for external interrupts also may not
    sleep, although they may invoke intr_yield_on_return() to
    request that a new process be scheduled just before the
-   interrupt returns. */
-static bool in_external_intr;   /* Are we processing an external interrupt? */
-static bool yield_on_return;    /* Should we yield on interrupt return? */
+   interrupt returns.  Each CPU keeps its own in_external_intr and
+   yield_on_return flags in struct cpu.
+
+   Turning interrupts off only keeps out the current CPU's
+   interrupt handlers and scheduler.  Data that other CPUs may
+   touch at the same time is protected by a spin lock, which is
+   always taken with interrupts off; see struct spinlock. */
 
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
@@ -128,15 +179,33 @@ intr_get_level (void) {
    returns the previous interrupt status. */
 enum intr_level
 intr_set_level (enum intr_level level) {
-	return level == INTR_ON ? intr_enable () : intr_disable ();
+	void *caller = __builtin_return_address (0);
+
+	return level == INTR_ON ? do_enable (caller) : do_disable (caller);
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_enable (void) {
+	return do_enable (__builtin_return_address (0));
+}
+
+/* Disables interrupts and returns the previous interrupt status. */
+enum intr_level
+intr_disable (void) {
+	return do_disable (__builtin_return_address (0));
+}
+
+/* Enables interrupts on behalf of CALLER and returns the
+   previous interrupt status. */
+static enum intr_level
+do_enable (void *caller) {
 	enum intr_level old_level = intr_get_level ();
 	ASSERT (!intr_context ());
 
+	if (old_level == INTR_OFF && intr_irqsoff_trace)
+		irqsoff_end (caller);
+
 	/* Enable interrupts by setting the interrupt flag.
 
 	   See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -146,9 +215,10 @@ intr_enable (void) {
 	return old_level;
 }
 
-/* Disables interrupts and returns the previous interrupt status. */
-enum intr_level
-intr_disable (void) {
+/* Disables interrupts on behalf of CALLER and returns the
+   previous interrupt status. */
+static enum intr_level
+do_disable (void *caller) {
 	enum intr_level old_level = intr_get_level ();
 
 	/* Disable interrupts by clearing the interrupt flag.
@@ -156,14 +226,155 @@ intr_disable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("cli" : : : "memory");
 
+	if (old_level == INTR_ON && intr_irqsoff_trace)
+		irqsoff_begin (caller);
+
 	return old_level;
 }
 
+/* Notes that CALLER just turned interrupts off. */
+static void
+irqsoff_begin (void *caller) {
+	struct cpu *c = cpu_current ();
+
+	c->irqsoff_start = rdtsc ();
+	c->irqsoff_caller = caller;
+}
+
+/* Notes that CALLER is about to turn interrupts back on, and
+   records the section that this ends. */
+static void
+irqsoff_end (void *caller) {
+	struct cpu *c = cpu_current ();
+	uint64_t cycles;
+	struct irqsoff *s, *min = NULL;
+
+	/* Interrupts went off some other way, e.g. through an
+	   interrupt gate. */
+	if (c->irqsoff_start == 0)
+		return;
+	cycles = rdtsc () - c->irqsoff_start;
+	c->irqsoff_start = 0;
+
+	spin_lock (&irqsoff_lock);
+	/* Find the entry for this section, or a free one, or else
+	   replace the least costly one if this beats it. */
+	for (s = irqsoffs; s < irqsoffs + IRQSOFF_CNT; s++) {
+		if (s->cnt == 0 || (s->off == c->irqsoff_caller && s->on == caller))
+			break;
+		if (min == NULL || s->max_cycles < min->max_cycles)
+			min = s;
+	}
+	if (s == irqsoffs + IRQSOFF_CNT) {
+		irqsoff_dropped++;
+		if (cycles <= min->max_cycles) {
+			spin_unlock (&irqsoff_lock);
+			return;
+		}
+		s = min;
+		s->cnt = 0;
+		s->max_cycles = 0;
+	}
+	s->off = c->irqsoff_caller;
+	s->on = caller;
+	s->cnt++;
+	if (cycles > s->max_cycles)
+		s->max_cycles = cycles;
+	spin_unlock (&irqsoff_lock);
+}
+
+/* Returns the longest interrupts-off section recorded since
+   the last intr_irqsoff_reset(), in cycles. */
+uint64_t
+intr_irqsoff_max (void) {
+	enum intr_level old_level = intr_disable ();
+	uint64_t max = 0;
+	struct irqsoff *s;
+
+	spin_lock (&irqsoff_lock);
+	for (s = irqsoffs; s < irqsoffs + IRQSOFF_CNT; s++)
+		if (s->cnt > 0 && s->max_cycles > max)
+			max = s->max_cycles;
+	spin_unlock (&irqsoff_lock);
+	intr_set_level (old_level);
+	return max;
+}
+
+/* Forgets the interrupts-off sections recorded so far. */
+void
+intr_irqsoff_reset (void) {
+	enum intr_level old_level = intr_disable ();
+
+	spin_lock (&irqsoff_lock);
+	memset (irqsoffs, 0, sizeof irqsoffs);
+	irqsoff_dropped = 0;
+	spin_unlock (&irqsoff_lock);
+	intr_set_level (old_level);
+}
+
+/* Prints the IRQSOFF_TOP longest interrupts-off sections, then
+   all of their addresses on one line, for utils/backtrace. */
+void
+intr_irqsoff_print (void) {
+	bool printed[IRQSOFF_CNT] = {false};
+	void *addrs[2 * IRQSOFF_TOP];
+	int i, n = 0;
+
+	printf ("Longest interrupts-off sections:\n");
+	for (i = 0; i < IRQSOFF_TOP; i++) {
+		struct irqsoff *s, *max = NULL;
+
+		for (s = irqsoffs; s < irqsoffs + IRQSOFF_CNT; s++)
+			if (s->cnt > 0 && !printed[s - irqsoffs]
+					&& (max == NULL || s->max_cycles > max->max_cycles))
+				max = s;
+		if (max == NULL)
+			break;
+		printed[max - irqsoffs] = true;
+		printf ("  %llu cycles max, %lld times: off at %p, on at %p\n",
+				(unsigned long long) max->max_cycles, max->cnt, max->off, max->on);
+		addrs[n++] = max->off;
+		addrs[n++] = max->on;
+	}
+	if (irqsoff_dropped > 0)
+		printf ("  (%lld sections not kept)\n", irqsoff_dropped);
+
+	printf ("Interrupts-off addresses:");
+	for (i = 0; i < n; i++)
+		printf (" %p", addrs[i]);
+	printf ("\n");
+	printf ("Run `backtrace' on them to find the code.\n");
+}
+
+/* Enables interrupts and waits for the next one to arrive.
+   Interrupts must be off on entry and are on when this returns.
+
+   The `sti' instruction disables interrupts until the
+   completion of the next instruction, so these two
+   instructions are executed atomically.  This atomicity is
+   important; otherwise, an interrupt could be handled
+   between re-enabling interrupts and waiting for the next
+   one to occur, wasting as much as one clock tick worth of
+   time.
+
+   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
+   7.11.1 "HLT Instruction". */
+void
+intr_wait (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (intr_irqsoff_trace)
+		irqsoff_end (__builtin_return_address (0));
+	asm volatile ("sti; hlt" : : : "memory");
+}
+
 /* Initializes the interrupt system. */
 void
 intr_init (void) {
 	int i;
 
+	spin_init (&irqsoff_lock);
+
 	/* Initialize interrupt controller. */
 	pic_init ();
 
@@ -203,6 +414,15 @@ intr_init (void) {
 	intr_names[19] = "#XF SIMD Floating-Point Exception";
 }
 
+/* Loads the IDT on an application processor, which runs with
+   interrupts off until it first waits for one. */
+void
+intr_init_ap (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	lidt (&idt_desc);
+}
+
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
    privilege level DPL.  Names the interrupt NAME for debugging
    purposes.  The interrupt handler will be invoked with
@@ -223,11 +443,12 @@ register_handler (uint8_t vec_no, int dpl, enum intr_level level,
 
 /* Registers external interrupt VEC_NO to invoke HANDLER, which
    is named NAME for debugging purposes.  The handler will
-   execute with interrupts disabled. */
+   execute with interrupts disabled.  Vectors 0x20...0x2f come
+   from the PIC, 0x30...0x3f from the local APIC. */
 void
 intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
 		const char *name) {
-	ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
+	ASSERT (vec_no >= 0x20 && vec_no <= 0x3f);
 	register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
@@ -248,7 +469,7 @@ void
 intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 		intr_handler_func *handler, const char *name)
 {
-	ASSERT (vec_no < 0x20 || vec_no > 0x2f);
+	ASSERT (vec_no < 0x20 || vec_no > 0x3f);
 	register_handler (vec_no, dpl, level, handler, name);
 }
 
@@ -256,7 +477,7 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
    and false at all other times. */
 bool
 intr_context (void) {
-	return in_external_intr;
+	return cpu_current ()->in_external_intr;
 }
 
 /* During processing of an external interrupt, directs the
@@ -266,7 +487,7 @@ intr_context (void) {
 void
 intr_yield_on_return (void) {
 	ASSERT (intr_context ());
-	yield_on_return = true;
+	cpu_current ()->yield_on_return = true;
 }
 
 /* 8259A Programmable Interrupt Controller. */
@@ -332,25 +553,46 @@ void
 intr_handler (struct intr_frame *frame) {
 	bool external;
 	intr_handler_func *handler;
+	struct cpu *c;
+	uint64_t start = 0, cycles;
+
+	/* Interrupts were on until the gate turned them off, so any
+	   section the tracer thinks is open has been closed by an
+	   iretq or sysretq it did not see. */
+	if (frame->eflags & FLAG_IF)
+		cpu_current ()->irqsoff_start = 0;
+
+#ifdef USERPROG
+	if (frame->cs == SEL_UCSEG)
+		thread_acct_enter_kernel ();
+#endif
 
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
-	   and they need to be acknowledged on the PIC (see below).
+	   and they need to be acknowledged on the PIC or the local
+	   APIC (see below).
 	   An external interrupt handler cannot sleep. */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+	external = frame->vec_no >= 0x20 && frame->vec_no < 0x40;
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (!intr_context ());
 
-		in_external_intr = true;
-		yield_on_return = false;
+		c = cpu_current ();
+		c->in_external_intr = true;
+		c->yield_on_return = false;
+
+		/* Catch up on ticks skipped by tickless idle before any
+		   handler looks at the time. */
+		timer_nohz_exit ();
+		start = rdtsc ();
 	}
 
 	/* Invoke the interrupt's handler. */
 	handler = intr_handlers[frame->vec_no];
 	if (handler != NULL)
 		handler (frame);
-	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
+	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f
+			|| frame->vec_no == LAPIC_SPURIOUS_VEC) {
 		/* There is no handler, but this interrupt can trigger
 		   spuriously due to a hardware fault or hardware race
 		   condition.  Ignore it. */
@@ -366,12 +608,38 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (intr_context ());
 
-		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
+		cycles = rdtsc () - start;
+		intr_cnts[frame->vec_no]++;
+		if (cycles > intr_max_cycles[frame->vec_no])
+			intr_max_cycles[frame->vec_no] = cycles;
 
-		if (yield_on_return)
+		c = cpu_current ();
+		c->in_external_intr = false;
+		if (frame->vec_no < 0x30)
+			pic_end_of_interrupt (frame->vec_no);
+		else if (frame->vec_no != LAPIC_SPURIOUS_VEC)
+			lapic_eoi ();
+
+		if (c->yield_on_return)
 			thread_yield ();
 	}
+
+#ifdef USERPROG
+	if (frame->cs == SEL_UCSEG)
+		thread_acct_exit_kernel ();
+#endif
+}
+
+/* Prints statistics for the external interrupts that occurred. */
+void
+intr_print_stats (void) {
+	int vec;
+
+	for (vec = 0x20; vec < 0x40; vec++)
+		if (intr_cnts[vec] > 0)
+			printf ("Interrupt %#04x (%s): %lld times, %llu cycles max\n",
+					vec, intr_names[vec], intr_cnts[vec],
+					(unsigned long long) intr_max_cycles[vec]);
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
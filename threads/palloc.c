@@ -2,12 +2,14 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -24,13 +26,65 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Its free pages are
+   kept as blocks of 2**ORDER pages, aligned to their size
+   relative to the pool's base, on one free list per order.  A
+   request for N pages takes a block of the smallest order that
+   fits, from the smallest order that has one, halving it as
+   needed, and gives back the pages past N.  A freed block is
+   merged with its "buddy", the other half of the block of the
+   next order up, for as long as the buddy is free too.  Both are
+   O(log n) in the size of the pool.  Each page has a free list
+   element and a byte that records the order of the free block
+   that starts there, if any.  They live beside the pool's
+   bitmap rather than in the free pages, which the boot page
+   table may not map.  used_map still records which pages are
+   allocated, to catch bad frees.
+
+   With -prezero, each pool also keeps a small reserve of free
+   pages that are already zeroed, so that a PAL_ZERO request for
+   a single page, as made for page tables, thread stacks and
+   zero-filled user pages, need not clear it.  It is off by
+   default because the idle thread's zeroing costs memory
+   bandwidth and cache on every idle CPU, which only pays off if
+   PAL_ZERO allocations are on a hot path.  The pages of the reserve are
+   allocated as far as the buddy lists are concerned, and are
+   linked through their free list elements.  The idle thread
+   refills the reserve a page at a time, through
+   palloc_zero_idle(), and an allocation that would otherwise
+   fail gives the reserve back to the buddy lists first.
+
+   Each pool is protected by a spin lock rather than a struct
+   lock, because the scheduler frees dead threads' pages with
+   interrupts already off, where it cannot sleep.  spin_set_name()
+   keeps the pools in the -lockstat report.  Every operation is
+   short, except that clearing used_map for a multi-page request
+   is O(page_cnt). */
+
+/* Orders of blocks run from 0, a single page, to MAX_ORDER. */
+#define MAX_ORDER 20
+
+/* free_order[] value for a page that does not start a free
+   block. */
+#define NOT_FREE 0xff
+
+/* Most pages to keep zeroed in each pool.  A pool keeps no more
+   than 1/16 of its pages zeroed. */
+#define ZERO_RESERVE 64
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
-	struct bitmap *used_map;        /* Bitmap of free pages. */
+	struct bitmap *used_map;        /* Bitmap of allocated pages. */
+	uint8_t *free_order;            /* Order of the free block at each page. */
+	struct list_elem *free_elems;   /* Free list element of each page. */
+	struct list free_lists[MAX_ORDER + 1]; /* Free blocks, by order. */
+	struct list zeroed;             /* Reserve of zeroed pages. */
+	size_t zeroed_cnt;              /* Number of pages in reserve. */
+	size_t zeroed_max;              /* Size the idle thread fills it to. */
 	uint8_t *base;                  /* Base of pool. */
+	struct spinlock lock;           /* Protects everything above. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -38,10 +92,22 @@ static struct pool kernel_pool, user_pool;
 
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
+
+/* Keep reserves of zeroed pages?  Set with -prezero. */
+bool palloc_prezero;
+
 static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
+init_pool (struct pool *p, const char *name, void **bm_base,
+		uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static struct list_elem *page_elem (struct pool *, size_t page_idx);
+static size_t elem_page (struct pool *, struct list_elem *);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void free_block (struct pool *, size_t page_idx, int order);
+static size_t alloc_pages (struct pool *, size_t page_cnt);
+static void release_zeroed (struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -158,7 +224,7 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 						break;
 					}
 					// generate kernel pool
-					init_pool (&kernel_pool,
+					init_pool (&kernel_pool, "kernel pool",
 							&free_start, region_start, start + rem * PGSIZE);
 					// Transition to the next state
 					if (rem == size_in_pg) {
@@ -188,7 +254,7 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 	}
 
 	// generate the user pool
-	init_pool(&user_pool, &free_start, region_start, end);
+	init_pool(&user_pool, "user pool", &free_start, region_start, end);
 
 	// Iterate over the e820_entry. Setup the usable.
 	uint64_t usable_bound = (uint64_t) free_start;
@@ -224,11 +290,13 @@ split:
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
 				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				buddy_free (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
 				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				buddy_free (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -262,19 +330,31 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
+	size_t page_idx = BITMAP_ERROR;
+	bool zeroed = false;
 	void *pages;
 
+	if (page_cnt != 0) {
+		enum intr_level old_level = intr_disable ();
+		spin_lock (&pool->lock);
+		if (page_cnt == 1 && (flags & PAL_ZERO) && palloc_prezero
+				&& !list_empty (&pool->zeroed)) {
+			page_idx = elem_page (pool, list_pop_front (&pool->zeroed));
+			pool->zeroed_cnt--;
+			zeroed = true;
+		} else
+			page_idx = alloc_pages (pool, page_cnt);
+		spin_unlock (&pool->lock);
+		intr_set_level (old_level);
+	}
+
 	if (page_idx != BITMAP_ERROR)
 		pages = pool->base + PGSIZE * page_idx;
 	else
 		pages = NULL;
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset (pages, 0, PGSIZE * page_cnt);
 	} else {
 		if (flags & PAL_ASSERT)
@@ -296,11 +376,13 @@ palloc_get_page (enum palloc_flags flags) {
 	return palloc_get_multiple (flags, 1);
 }
 
-/* Frees the PAGE_CNT pages starting at PAGES. */
+/* Frees the PAGE_CNT pages starting at PAGES.  May be called
+   with interrupts off. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) {
 	struct pool *pool;
 	size_t page_idx;
+	enum intr_level old_level;
 
 	ASSERT (pg_ofs (pages) == 0);
 	if (pages == NULL || page_cnt == 0)
@@ -318,8 +400,13 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	old_level = intr_disable ();
+	spin_lock (&pool->lock);
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
 	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	buddy_free (pool, page_idx, page_cnt);
+	spin_unlock (&pool->lock);
+	intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -328,23 +415,210 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Zeroes one free page for the reserve of a pool that is short
+   of them, with interrupts on while it does so.  Returns true if
+   it zeroed a page, false if every reserve is full or there is
+   no free page.  Called by the idle thread, with interrupts off,
+   whenever no other thread is ready; returns with interrupts
+   off. */
+bool
+palloc_zero_idle (void) {
+	struct pool *pool;
+	size_t page_idx;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!palloc_prezero)
+		return false;
+
+	/* Refill the emptier reserve first.  The counts are read
+	   without the pools' locks, so idle threads on several CPUs
+	   may overfill a reserve by a page or two. */
+	pool = &user_pool;
+	if (kernel_pool.zeroed_cnt < kernel_pool.zeroed_max
+			&& (user_pool.zeroed_cnt >= user_pool.zeroed_max
+				|| kernel_pool.zeroed_max - kernel_pool.zeroed_cnt
+				> user_pool.zeroed_max - user_pool.zeroed_cnt))
+		pool = &kernel_pool;
+	if (pool->zeroed_cnt >= pool->zeroed_max)
+		return false;
+
+	spin_lock (&pool->lock);
+	page_idx = buddy_alloc (pool, 1);
+	if (page_idx != BITMAP_ERROR) {
+		ASSERT (!bitmap_test (pool->used_map, page_idx));
+		bitmap_mark (pool->used_map, page_idx);
+	}
+	spin_unlock (&pool->lock);
+	if (page_idx == BITMAP_ERROR)
+		return false;
+
+	intr_enable ();
+	memset (pool->base + PGSIZE * page_idx, 0, PGSIZE);
+	intr_disable ();
+
+	spin_lock (&pool->lock);
+	list_push_front (&pool->zeroed, page_elem (pool, page_idx));
+	pool->zeroed_cnt++;
+	spin_unlock (&pool->lock);
+	return true;
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+init_pool (struct pool *p, const char *name, void **bm_base,
+		uint64_t start, uint64_t end) {
+  /* We'll put the pool's used_map, free_order and free_elems
+     at its base.  Calculate the space needed for them
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t order_pages = DIV_ROUND_UP (pgcnt, PGSIZE) * PGSIZE;
+	size_t elem_pages = DIV_ROUND_UP (pgcnt * sizeof (struct list_elem),
+			PGSIZE) * PGSIZE;
+	int order;
 
-	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	p->free_order = *bm_base + bm_pages;
+	p->free_elems = *bm_base + bm_pages + order_pages;
+	for (order = 0; order <= MAX_ORDER; order++)
+		list_init (&p->free_lists[order]);
+	list_init (&p->zeroed);
+	p->zeroed_cnt = 0;
+	spin_init (&p->lock);
+	spin_set_name (&p->lock, name);
+	p->zeroed_max = pgcnt / 16 < ZERO_RESERVE ? pgcnt / 16 : ZERO_RESERVE;
 	p->base = (void *) start;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
+	memset (p->free_order, NOT_FREE, pgcnt);
+
+	*bm_base += bm_pages + order_pages + elem_pages;
+}
 
-	*bm_base += bm_pages;
+/* Returns the free list element of page PAGE_IDX of POOL. */
+static struct list_elem *
+page_elem (struct pool *pool, size_t page_idx) {
+	return &pool->free_elems[page_idx];
+}
+
+/* Returns the index in POOL of the page whose free list element
+   is E. */
+static size_t
+elem_page (struct pool *pool, struct list_elem *e) {
+	return e - pool->free_elems;
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL, marks them
+   used, and returns the index of the first, or BITMAP_ERROR if
+   there is no free block big enough even after giving back the
+   reserve of zeroed pages.  Interrupts must be off. */
+static size_t
+alloc_pages (struct pool *pool, size_t page_cnt) {
+	size_t page_idx = buddy_alloc (pool, page_cnt);
+
+	if (page_idx == BITMAP_ERROR && pool->zeroed_cnt > 0) {
+		release_zeroed (pool);
+		page_idx = buddy_alloc (pool, page_cnt);
+	}
+	if (page_idx != BITMAP_ERROR) {
+		ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+		bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+	}
+	return page_idx;
+}
+
+/* Gives every page in POOL's reserve of zeroed pages back to the
+   buddy lists.  Interrupts must be off. */
+static void
+release_zeroed (struct pool *pool) {
+	while (!list_empty (&pool->zeroed)) {
+		size_t page_idx = elem_page (pool, list_pop_front (&pool->zeroed));
+
+		bitmap_reset (pool->used_map, page_idx);
+		free_block (pool, page_idx, 0);
+	}
+	pool->zeroed_cnt = 0;
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or BITMAP_ERROR if there is no free block
+   big enough.  Interrupts must be off. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt) {
+	int want = 0, order;
+	size_t page_idx;
+
+	while (((size_t) 1 << want) < page_cnt)
+		if (++want > MAX_ORDER)
+			return BITMAP_ERROR;
+
+	/* Smallest free block that is big enough. */
+	for (order = want; order <= MAX_ORDER; order++)
+		if (!list_empty (&pool->free_lists[order]))
+			break;
+	if (order > MAX_ORDER)
+		return BITMAP_ERROR;
+	page_idx = elem_page (pool, list_pop_front (&pool->free_lists[order]));
+	pool->free_order[page_idx] = NOT_FREE;
+
+	/* Split it down to size, freeing the upper halves. */
+	while (order > want) {
+		size_t buddy;
+
+		order--;
+		buddy = page_idx + ((size_t) 1 << order);
+		pool->free_order[buddy] = order;
+		list_push_front (&pool->free_lists[order], page_elem (pool, buddy));
+	}
+
+	/* Give back the pages past PAGE_CNT. */
+	if (((size_t) 1 << want) > page_cnt)
+		buddy_free (pool, page_idx + page_cnt,
+				((size_t) 1 << want) - page_cnt);
+	return page_idx;
+}
+
+/* Frees the PAGE_CNT pages of POOL starting at PAGE_IDX, as the
+   largest aligned blocks that they can be split into.
+   Interrupts must be off. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order < MAX_ORDER
+				&& page_idx % ((size_t) 2 << order) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		free_block (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Frees the block of 2**ORDER pages of POOL at PAGE_IDX, and
+   merges it with its buddy for as long as the buddy is free.
+   Interrupts must be off. */
+static void
+free_block (struct pool *pool, size_t page_idx, int order) {
+	size_t pool_pages = bitmap_size (pool->used_map);
+
+	while (order < MAX_ORDER) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy + ((size_t) 1 << order) > pool_pages
+				|| pool->free_order[buddy] != order)
+			break;
+		list_remove (page_elem (pool, buddy));
+		pool->free_order[buddy] = NOT_FREE;
+		if (buddy < page_idx)
+			page_idx = buddy;
+		order++;
+	}
+	pool->free_order[page_idx] = order;
+	list_push_front (&pool->free_lists[order], page_elem (pool, page_idx));
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -0,0 +1,280 @@
+#include "threads/rcu.h"
+#include <debug.h>
+#include <list.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/workqueue.h"
+
+/* Read-copy update.  See rcu.h.
+
+   rcu_gp_seq counts the grace periods started and gp_done those
+   completed, so a grace period is in progress while they differ.
+   Grace period G completes once both of these hold:
+
+   - Every CPU has passed through a quiescent state since G
+     started, that is, a moment at which the thread running there
+     was outside any read-side critical section.  schedule()
+     reports one at every thread switch, and the timer tick
+     reports one whenever it interrupts a thread that is outside
+     a critical section, so that an idle CPU, or one running a
+     single thread, still reports one within a tick.  A switch
+     is reported from schedule_tail(), once the scheduler has let
+     go of its locks, because completing a grace period may wake
+     a worker.
+
+   - Every thread that was preempted inside a critical section
+     that began before G started has left it.  Switching away
+     from such a thread must not hold up its CPU, so schedule()
+     puts it on blocked_readers instead, and the outermost
+     rcu_read_unlock() takes it off again.
+
+   A reader that began after G started cannot see anything that
+   was removed before G started, so G need not wait for it.  On
+   the fast path, then, a reader only increments and decrements
+   a counter in its own thread and loads rcu_gp_seq.
+
+   Callbacks wait, in order, for the first grace period that
+   starts after they are queued.  Once it completes, a workqueue
+   worker runs them with interrupts on, since they usually free
+   memory.
+
+   Everything here is protected by rcu_lock, except each CPU's
+   rcu_qs_gp, which only its own CPU writes, under rcu_lock, and
+   which is read without it to skip the lock when there is
+   nothing to report.  Callbacks are handed to the workqueue after
+   rcu_lock is released. */
+
+volatile int64_t rcu_gp_seq;
+
+/* Number of grace periods completed. */
+static int64_t gp_done;
+
+static struct spinlock rcu_lock;
+
+/* Threads preempted inside a read-side critical section. */
+static struct list blocked_readers;
+
+/* Callbacks waiting for a grace period, oldest first. */
+static struct rcu_head *wait_head;
+static struct rcu_head **wait_tail;
+
+/* Callbacks whose grace period has completed, oldest first. */
+static struct rcu_head *done_head;
+static struct rcu_head **done_tail;
+
+/* Runs the callbacks in done_head. */
+static struct work callback_work;
+
+/* A call to synchronize_rcu(). */
+struct rcu_sync {
+	struct rcu_head head;       /* Callback that ends the wait. */
+	struct semaphore done;      /* Upped by the callback. */
+};
+
+static void gp_start (void);
+static bool gp_check (void);
+static void run_callbacks (void *aux);
+static rcu_func wake_synchronizer;
+
+/* Initializes RCU.  Callbacks may be queued from here on, but
+   do not run before workqueue_start(). */
+void
+rcu_init (void) {
+	list_init (&blocked_readers);
+	spin_init (&rcu_lock);
+	wait_tail = &wait_head;
+	done_tail = &done_head;
+	work_init (&callback_work, run_callbacks, NULL);
+}
+
+/* Arranges for FUNC to be called with HEAD, in a kernel thread,
+   after a grace period has passed, that is, once every RCU
+   reader that might have seen the structure that HEAD is
+   embedded in has finished.  Does not wait.  May be called from
+   an interrupt handler or in a read-side critical section. */
+void
+call_rcu (struct rcu_head *head, rcu_func *func) {
+	enum intr_level old_level;
+
+	ASSERT (head != NULL);
+	ASSERT (func != NULL);
+
+	old_level = intr_disable ();
+	spin_lock (&rcu_lock);
+	head->next = NULL;
+	head->func = func;
+	head->gp = rcu_gp_seq + 1;
+	*wait_tail = head;
+	wait_tail = &head->next;
+	if (gp_done == rcu_gp_seq)
+		gp_start ();
+	spin_unlock (&rcu_lock);
+	intr_set_level (old_level);
+}
+
+/* Waits until a grace period has passed, that is, until every
+   RCU read-side critical section that began before the call has
+   ended.  Must not be called in a read-side critical section,
+   or before workqueue_start(). */
+void
+synchronize_rcu (void) {
+	struct rcu_sync sync;
+
+	ASSERT (!intr_context ());
+	ASSERT (!rcu_read_lock_held ());
+
+	sema_init (&sync.done, 0);
+	call_rcu (&sync.head, wake_synchronizer);
+	sema_down (&sync.done);
+}
+
+/* rcu_func for synchronize_rcu(). */
+static void
+wake_synchronizer (struct rcu_head *head) {
+	sema_up (&rcu_entry (head, struct rcu_sync, head)->done);
+}
+
+/* Called by schedule() when the running thread, CURR, is about
+   to give up the CPU, before any other CPU can pick it up.  If
+   CURR is in a read-side critical section, it goes on
+   blocked_readers so that grace periods still wait for it.  The
+   switch itself is reported later, by rcu_quiescent_state().
+   Interrupts must be off. */
+void
+rcu_note_switch (struct thread *curr) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (curr->rcu_nesting > 0 && !curr->rcu_blocked) {
+		ASSERT (curr->status != THREAD_DYING);
+		spin_lock (&rcu_lock);
+		curr->rcu_blocked = true;
+		list_push_back (&blocked_readers, &curr->rcu_elem);
+		spin_unlock (&rcu_lock);
+	}
+}
+
+/* Called by the timer interrupt handler on every CPU.  If the
+   interrupted thread is outside any read-side critical section,
+   this is a quiescent state for the CPU. */
+void
+rcu_tick (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (thread_current ()->rcu_nesting == 0)
+		rcu_quiescent_state ();
+}
+
+/* Notes a quiescent state on the current CPU: a thread switch
+   has just completed, or the timer tick found the CPU outside
+   any read-side critical section.  A thread that was switched
+   back in while inside one is on blocked_readers, so it does not
+   matter that it is running now.  Must not be called with any
+   spin lock held. */
+void
+rcu_quiescent_state (void) {
+	struct cpu *c = cpu_current ();
+	bool ready;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (c->rcu_qs_gp == rcu_gp_seq)
+		return;
+	spin_lock (&rcu_lock);
+	c->rcu_qs_gp = rcu_gp_seq;
+	ready = gp_check ();
+	spin_unlock (&rcu_lock);
+	if (ready)
+		queue_work (&callback_work);
+}
+
+/* Called by rcu_read_unlock() when a thread that was preempted
+   in a read-side critical section leaves it. */
+void
+rcu_read_unlock_special (void) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level = intr_disable ();
+	bool ready = false;
+
+	spin_lock (&rcu_lock);
+	if (t->rcu_blocked && t->rcu_nesting == 0) {
+		list_remove (&t->rcu_elem);
+		t->rcu_blocked = false;
+		ready = gp_check ();
+	}
+	spin_unlock (&rcu_lock);
+	if (ready)
+		queue_work (&callback_work);
+	intr_set_level (old_level);
+}
+
+/* Starts a new grace period.  None may be in progress. */
+static void
+gp_start (void) {
+	ASSERT (gp_done == rcu_gp_seq);
+	rcu_gp_seq++;
+}
+
+/* Completes the grace period in progress, if there is one and
+   nothing holds it up any longer.  Moves the callbacks that were
+   waiting for it to done_head, and starts another grace period
+   for any that are left.  Returns true if the caller should
+   queue callback_work once it has released rcu_lock. */
+static bool
+gp_check (void) {
+	int64_t gp = rcu_gp_seq;
+	struct list_elem *e;
+	bool ready = false;
+	int i;
+
+	ASSERT (spin_held_by_current_cpu (&rcu_lock));
+
+	if (gp_done == gp)
+		return false;
+	for (i = 0; i < cpu_cnt; i++)
+		if (cpus[i].rcu_qs_gp < gp)
+			return false;
+	for (e = list_begin (&blocked_readers); e != list_end (&blocked_readers);
+			e = list_next (e))
+		if (list_entry (e, struct thread, rcu_elem)->rcu_read_gp < gp)
+			return false;
+
+	gp_done = gp;
+	while (wait_head != NULL && wait_head->gp <= gp_done) {
+		struct rcu_head *head = wait_head;
+
+		wait_head = head->next;
+		head->next = NULL;
+		*done_tail = head;
+		done_tail = &head->next;
+		ready = true;
+	}
+	if (wait_head == NULL)
+		wait_tail = &wait_head;
+
+	if (wait_head != NULL)
+		gp_start ();
+	return ready;
+}
+
+/* Work function that runs the callbacks whose grace period has
+   completed. */
+static void
+run_callbacks (void *aux UNUSED) {
+	struct rcu_head *head;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	spin_lock (&rcu_lock);
+	head = done_head;
+	done_head = NULL;
+	done_tail = &done_head;
+	spin_unlock (&rcu_lock);
+	intr_set_level (old_level);
+
+	while (head != NULL) {
+		struct rcu_head *next = head->next;
+
+		head->func (head);
+		head = next;
+	}
+}
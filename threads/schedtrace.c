@@ -0,0 +1,87 @@
+#include "threads/schedtrace.h"
+#include <debug.h>
+#include <intrinsic.h>
+#include <stdio.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+
+/* Scheduler event trace.  See schedtrace.h.
+
+   The ring buffer is shared by all CPUs and protected by
+   trace_lock.  Events are recorded with the scheduler's own
+   locks held, so trace_lock is taken last and held only for the
+   few stores of one event.  Once the ring is full, new events
+   overwrite the oldest ones. */
+
+/* Number of events kept.  Must be a power of 2. */
+#define SCHED_TRACE_SIZE 8192
+
+/* One event.  Kept small, so that the ring covers a long
+   stretch of time. */
+struct sched_event {
+	uint64_t tsc;               /* Time stamp counter. */
+	int32_t tid;                /* Thread. */
+	uint8_t cpu;                /* CPU that recorded the event. */
+	uint8_t priority;           /* Thread's priority, after the event. */
+	uint8_t old_status;         /* enum thread_status before the event. */
+	uint8_t new_status;         /* enum thread_status after the event. */
+	uint8_t reason;             /* enum sched_trace_reason. */
+};
+
+/* Enable tracing?  Set by the -sched-trace option. */
+bool sched_trace_enabled;
+
+static struct sched_event ring[SCHED_TRACE_SIZE];
+static uint64_t event_cnt;      /* # of events ever recorded. */
+static struct spinlock trace_lock;
+
+static const char *status_names[] = {"running", "ready", "blocked", "dying"};
+static const char *reason_names[] = {
+	"switch-out", "switch-in", "block", "unblock", "wake", "priority"
+};
+
+/* Records that thread T went from status OLD to NEW, for
+   REASON.  Interrupts must be off. */
+void
+sched_trace_record (const struct thread *t, enum thread_status old,
+		enum thread_status new, enum sched_trace_reason reason) {
+	struct sched_event *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&trace_lock);
+	e = &ring[event_cnt++ % SCHED_TRACE_SIZE];
+	e->tsc = rdtsc ();
+	e->tid = t->tid;
+	e->cpu = cpu_current ()->id;
+	e->priority = t->priority;
+	e->old_status = old;
+	e->new_status = new;
+	e->reason = reason;
+	spin_unlock (&trace_lock);
+}
+
+/* Prints the events in the ring, oldest first, as CSV lines
+   prefixed with "st," so that they can be picked out of the
+   rest of the console output.  Tracing stops while printing. */
+void
+sched_trace_dump (void) {
+	bool enabled = sched_trace_enabled;
+	uint64_t first, i;
+
+	sched_trace_enabled = false;
+	first = event_cnt > SCHED_TRACE_SIZE ? event_cnt - SCHED_TRACE_SIZE : 0;
+	printf ("Sched trace: %llu events, %llu dropped\n",
+			(unsigned long long) event_cnt, (unsigned long long) first);
+	printf ("st,tsc,cpu,tid,priority,old,new,reason\n");
+	for (i = first; i < event_cnt; i++) {
+		const struct sched_event *e = &ring[i % SCHED_TRACE_SIZE];
+
+		printf ("st,%llu,%d,%d,%d,%s,%s,%s\n",
+				(unsigned long long) e->tsc, e->cpu, e->tid, e->priority,
+				status_names[e->old_status], status_names[e->new_status],
+				reason_names[e->reason]);
+	}
+	sched_trace_enabled = enabled;
+}
@@ -0,0 +1,275 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Object caches.  See slab.h.
+
+   Each slab is a single page.  It starts with a struct slab,
+   followed by the objects, each in a slot of the object size
+   rounded up to the cache's alignment.  The free objects of a
+   slab form a singly linked list through a pointer kept in each
+   free slot: at the start of the slot, or, if the cache has a
+   constructor, just past the object, so that the object's
+   constructed state survives.
+
+   A cache keeps its slabs on three lists, by how many of their
+   objects are in use, and allocates from partly used slabs
+   first so that the others can empty out.  It keeps at most one
+   empty slab, and gives the rest back to the page allocator.
+
+   The space left over at the end of a slab is used to "color"
+   slabs: successive slabs start their objects at successive
+   multiples of the cache line size within it, so that objects at
+   the same index in different slabs do not all compete for the
+   same cache sets.  See Bonwick, "The Slab Allocator: An
+   Object-Caching Kernel Memory Allocator", USENIX Summer 1994. */
+
+/* Most caches there may be. */
+#define CACHE_MAX 32
+
+/* Cache line size, the unit of slab coloring. */
+#define CACHE_LINE 64
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* An object cache. */
+struct kmem_cache {
+	const char *name;           /* For statistics. */
+	size_t size;                /* Object size. */
+	size_t slot_size;           /* Bytes per object in a slab. */
+	size_t link_ofs;            /* Offset of free link in a free slot. */
+	size_t obj_ofs;             /* Offset of first object in a slab. */
+	size_t objs_per_slab;       /* Objects in each slab. */
+	size_t color_step;          /* Offset between slab colors. */
+	size_t color_cnt;           /* Number of colors. */
+	size_t next_color;          /* Color of the next slab. */
+	kmem_ctor *ctor;            /* Constructor, or a null pointer. */
+	struct lock lock;           /* Protects everything below. */
+	struct list full;           /* Slabs with no free objects. */
+	struct list partial;        /* Slabs with some free objects. */
+	struct list empty;          /* Slabs with no objects in use. */
+
+	/* Statistics. */
+	size_t slab_cnt;            /* Slabs allocated now. */
+	size_t active_cnt;          /* Objects in use now. */
+	long long alloc_cnt;        /* Objects allocated, ever. */
+};
+
+/* A slab, at the start of its page. */
+struct slab {
+	unsigned magic;             /* Always SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in one of cache's lists. */
+	uint8_t *free;              /* First free object, or null. */
+	size_t inuse;               /* Objects in use. */
+};
+
+static struct kmem_cache caches[CACHE_MAX];
+static size_t cache_cnt;
+static struct spinlock caches_lock;     /* Protects cache_cnt. */
+
+static struct slab *slab_create (struct kmem_cache *);
+static uint8_t **free_link (struct kmem_cache *, uint8_t *obj);
+
+/* Creates and returns a cache of objects of SIZE bytes, aligned
+   to ALIGN bytes, which must be a power of 2, or to the size of
+   a pointer if ALIGN is 0.  If CTOR is nonnull, it constructs
+   each object when its slab is created.  NAME, which must remain
+   valid, identifies the cache in statistics.  Panics if too
+   many caches have been created or SIZE is too big for a slab. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor *ctor) {
+	struct kmem_cache *c;
+	enum intr_level old_level;
+	size_t leftover;
+
+	ASSERT (name != NULL);
+	ASSERT (size > 0);
+	if (align < sizeof (void *))
+		align = sizeof (void *);
+	ASSERT ((align & (align - 1)) == 0);
+
+	old_level = intr_disable ();
+	spin_lock (&caches_lock);
+	if (cache_cnt >= CACHE_MAX)
+		PANIC ("too many object caches");
+	c = &caches[cache_cnt++];
+	spin_unlock (&caches_lock);
+	intr_set_level (old_level);
+
+	c->name = name;
+	c->size = size;
+	c->ctor = ctor;
+	c->link_ofs = ctor != NULL ? ROUND_UP (size, sizeof (void *)) : 0;
+	c->slot_size = ROUND_UP (ctor != NULL ? c->link_ofs + sizeof (void *) : size,
+			align);
+	c->obj_ofs = ROUND_UP (sizeof (struct slab), align);
+	c->objs_per_slab = (PGSIZE - c->obj_ofs) / c->slot_size;
+	if (c->objs_per_slab == 0)
+		PANIC ("%s: %zu-byte objects are too big for a slab", name, size);
+	leftover = PGSIZE - c->obj_ofs - c->objs_per_slab * c->slot_size;
+	c->color_step = align > CACHE_LINE ? align : CACHE_LINE;
+	c->color_cnt = leftover / c->color_step + 1;
+	c->next_color = 0;
+
+	lock_init (&c->lock);
+	lock_set_name (&c->lock, name);
+	list_init (&c->full);
+	list_init (&c->partial);
+	list_init (&c->empty);
+	c->slab_cnt = c->active_cnt = 0;
+	c->alloc_cnt = 0;
+	return c;
+}
+
+/* Allocates and returns an object from cache C, or a null
+   pointer if memory is not available.  If C has a constructor,
+   the object is in its constructed state; otherwise its contents
+   are undefined. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	uint8_t *obj;
+
+	ASSERT (c != NULL);
+
+	lock_acquire (&c->lock);
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else if (!list_empty (&c->empty)) {
+		s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+		list_push_front (&c->partial, &s->elem);
+	} else {
+		s = slab_create (c);
+		if (s == NULL) {
+			lock_release (&c->lock);
+			return NULL;
+		}
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	obj = s->free;
+	s->free = *free_link (c, obj);
+	if (++s->inuse == c->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&c->full, &s->elem);
+	}
+	c->active_cnt++;
+	c->alloc_cnt++;
+	lock_release (&c->lock);
+	return obj;
+}
+
+/* Returns object OBJ, which must have been allocated from cache
+   C, to C.  Does nothing if OBJ is a null pointer. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj_) {
+	uint8_t *obj = obj_;
+	struct slab *s;
+
+	if (obj == NULL)
+		return;
+
+	s = pg_round_down (obj);
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs.  An
+	   object with a constructor must keep its state. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->size);
+#endif
+
+	lock_acquire (&c->lock);
+	*free_link (c, obj) = s->free;
+	s->free = obj;
+	if (s->inuse-- == c->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	if (s->inuse == 0) {
+		list_remove (&s->elem);
+		if (list_empty (&c->empty))
+			list_push_front (&c->empty, &s->elem);
+		else {
+			s->magic = 0;
+			palloc_free_page (s);
+			c->slab_cnt--;
+		}
+	}
+	c->active_cnt--;
+	lock_release (&c->lock);
+}
+
+/* Prints statistics for every cache: how much memory its slabs
+   take, next to what malloc() would have taken for the objects
+   in use. */
+void
+kmem_print_stats (void) {
+	size_t i;
+
+	for (i = 0; i < cache_cnt; i++) {
+		struct kmem_cache *c = &caches[i];
+		size_t block_size = 16;
+
+		while (block_size < c->size)
+			block_size *= 2;
+		printf ("Slab: %s: %zu-byte objects, %zu per slab, "
+				"%zu in use in %zu slabs (%zu bytes, malloc: %zu), "
+				"%lld allocated\n",
+				c->name, c->size, c->objs_per_slab, c->active_cnt,
+				c->slab_cnt, c->slab_cnt * PGSIZE,
+				c->active_cnt * block_size, c->alloc_cnt);
+	}
+}
+
+/* Creates a new slab for cache C, constructs its objects, and
+   returns it.  Returns a null pointer if no page is available.
+   C's lock must be held. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s = palloc_get_page (0);
+	uint8_t *first;
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->inuse = 0;
+	s->free = NULL;
+
+	/* Lay out the objects at the next color, and put them on the
+	   free list in address order. */
+	first = (uint8_t *) s + c->obj_ofs + c->next_color * c->color_step;
+	if (++c->next_color == c->color_cnt)
+		c->next_color = 0;
+	for (i = c->objs_per_slab; i-- > 0; ) {
+		uint8_t *obj = first + i * c->slot_size;
+
+		if (c->ctor != NULL)
+			c->ctor (obj);
+		*free_link (c, obj) = s->free;
+		s->free = obj;
+	}
+	c->slab_cnt++;
+	return s;
+}
+
+/* Returns the free link of free object OBJ in cache C. */
+static uint8_t **
+free_link (struct kmem_cache *c, uint8_t *obj) {
+	return (uint8_t **) (obj + c->link_ofs);
+}
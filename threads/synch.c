@@ -29,11 +29,137 @@
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
+
+static bool waitq_less (const struct heap_elem *, const struct heap_elem *,
+		void *aux);
+static struct thread *lock_update_donee (struct lock *);
+static void donate_chain (struct thread *, int depth);
+static void rw_donate (struct rwlock *, int priority, int depth);
+static int rw_donated_priority (struct thread *);
+static struct lock_stat *lockstat_class (const char *name, void *site);
+static void lockstat_acquired (struct lock_stat *, uint64_t *acquire_tsc,
+		bool contended, uint64_t wait);
+static void lockstat_released (struct lock_stat *, uint64_t acquire_tsc);
+
+/* Protects every wait queue, semaphore value, reader-writer
+   lock and condition variable, and the priority donation state
+   of locks and threads: wait_on_lock, held_locks and the
+   priorities that donation sets.  Donation follows chains from
+   waiter to lock to holder and on, across any number of locks, so
+   one lock covers them all rather than one per object.  That
+   serializes the slow paths of every CPU, but the lock fast paths
+   in lock_acquire() and lock_release() never take it.
+
+   synch_lock comes after a subsystem's own spin lock, if any, and
+   before the run queue locks; see thread.c. */
+struct spinlock synch_lock;
+
+/* Arrival order of waiters, for breaking priority ties. */
+static unsigned wait_seq_next;
+
+/* Turns interrupts off and acquires synch_lock.  Returns the
+   previous interrupt level, for synch_exit(). */
+enum intr_level
+synch_enter (void) {
+	enum intr_level old_level = intr_disable ();
+
+	spin_lock (&synch_lock);
+	return old_level;
+}
+
+/* Releases synch_lock and sets the interrupt level back to
+   OLD_LEVEL. */
+void
+synch_exit (enum intr_level old_level) {
+	spin_unlock (&synch_lock);
+	intr_set_level (old_level);
+}
+
+/* Initializes WQ as an empty wait queue.  A wait queue holds
+   threads waiting for some event, and hands them out highest
+   priority first, and in order of arrival among threads of equal
+   priority.  It is a heap, so that adding and removing a thread
+   cost O(log n) however many are waiting.
+
+   A thread can be in at most one wait queue, which it records in
+   its `waitq' member, and it stays in the right place even if
+   its priority changes while it waits: see
+   thread_set_effective_priority().  All wait queue functions
+   must be called with synch_lock held. */
+void
+waitq_init (struct waitq *wq) {
+	ASSERT (wq != NULL);
+
+	heap_init (&wq->threads, waitq_less, NULL);
+}
+
+/* Adds T, which must not be in any wait queue, to WQ.  Does not
+   block T. */
+void
+waitq_push (struct waitq *wq, struct thread *t) {
+	ASSERT (spin_held_by_current_cpu (&synch_lock));
+	ASSERT (t->waitq == NULL);
+
+	t->waitq = wq;
+	t->wait_seq = wait_seq_next++;
+	heap_insert (&wq->threads, &t->wait_elem);
+}
+
+/* Removes and returns the highest priority thread in WQ, which
+   must not be empty.  Does not unblock it. */
+struct thread *
+waitq_pop (struct waitq *wq) {
+	struct thread *t;
 
-// 수정!!
-bool sema_priority_cmp (const struct list_elem *l, const struct list_elem *s, void *aux UNUSED);
+	ASSERT (spin_held_by_current_cpu (&synch_lock));
+
+	t = heap_entry (heap_pop_max (&wq->threads), struct thread, wait_elem);
+	t->waitq = NULL;
+	return t;
+}
+
+/* Returns the highest priority thread in WQ, or a null pointer
+   if WQ is empty. */
+struct thread *
+waitq_max (const struct waitq *wq) {
+	struct heap_elem *e = heap_max (&wq->threads);
+
+	return e != NULL ? heap_entry (e, struct thread, wait_elem) : NULL;
+}
+
+/* Moves T within its wait queue after its priority has
+   changed. */
+void
+waitq_update (struct thread *t) {
+	ASSERT (spin_held_by_current_cpu (&synch_lock));
+	ASSERT (t->waitq != NULL);
+
+	heap_update (&t->waitq->threads, &t->wait_elem);
+}
+
+/* Returns true if WQ is empty, false otherwise. */
+bool
+waitq_empty (const struct waitq *wq) {
+	return heap_empty (&wq->threads);
+}
+
+/* Returns true if the thread waiting in A should be woken after
+   the one waiting in B: it has lower priority, or the same
+   priority and arrived later. */
+static bool
+waitq_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	const struct thread *ta = heap_entry (a, struct thread, wait_elem);
+	const struct thread *tb = heap_entry (b, struct thread, wait_elem);
+
+	if (ta->priority != tb->priority)
+		return ta->priority < tb->priority;
+	return (int) (ta->wait_seq - tb->wait_seq) > 0;
+}
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -49,7 +175,7 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	waitq_init (&sema->waiters);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -67,15 +193,13 @@ sema_down (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 	ASSERT (!intr_context ());
 
-	old_level = intr_disable ();
+	old_level = synch_enter ();
 	while (sema->value == 0) {
-		list_insert_ordered(&sema->waiters, &thread_current()->elem, cmp_thread_priority, NULL); // 수정!!
-
-		// list_push_back (&sema->waiters, &thread_current ()->elem);
-		thread_block ();
+		waitq_push (&sema->waiters, thread_current ()); // priority 순으로 대기
+		thread_block_locked (&synch_lock);
 	}
 	sema->value--;
-	intr_set_level (old_level);
+	synch_exit (old_level);
 }
 
 /* Down or "P" operation on a semaphore, but only if the
@@ -90,7 +214,7 @@ sema_try_down (struct semaphore *sema) {
 
 	ASSERT (sema != NULL);
 
-	old_level = intr_disable ();
+	old_level = synch_enter ();
 	if (sema->value > 0)
 	{
 		sema->value--;
@@ -98,7 +222,7 @@ sema_try_down (struct semaphore *sema) {
 	}
 	else
 		success = false;
-	intr_set_level (old_level);
+	synch_exit (old_level);
 
 	return success;
 }
@@ -113,17 +237,13 @@ sema_up (struct semaphore *sema) {
 
 	ASSERT (sema != NULL);
 
-	old_level = intr_disable ();
-    if (!list_empty(&sema->waiters)) // 대기 중인 스레드를 깨움
-    {
-        // waiters에 들어있는 스레드가 donate를 받아 우선순위가 달라졌을 수 있기 때문에 재정렬
-        list_sort(&sema->waiters, cmp_thread_priority, NULL);
-        thread_unblock(list_entry(list_pop_front(&sema->waiters), struct thread, elem));
-    }
-	
+	old_level = synch_enter ();
+	if (!waitq_empty (&sema->waiters)) // 대기 중인 스레드를 깨움
+		thread_unblock (waitq_pop (&sema->waiters));
+
 	sema->value++;
-	thread_test_preemption(); // 추가 , 수정!!
-	intr_set_level (old_level);
+	synch_exit (old_level);
+	preempt_priority(); // 추가 , 수정!!
 }
 
 static void sema_test_helper (void *sema_);
@@ -175,13 +295,69 @@ sema_test_helper (void *sema_) {
    another one "up" it, but with a lock the same thread must both
    acquire and release it.  When these restrictions prove
    onerous, it's a good sign that a semaphore should be used,
-   instead of a lock. */
+   instead of a lock.
+
+   A lock that nobody waits for is taken and dropped with a single
+   atomic instruction on HOLDER.  Only when that fails does
+   lock_acquire() fall back to queuing on WAITERS and donating its
+   priority, and it sets CONTENDED first, so that lock_release()
+   knows to look at the waiters.
+
+   Donation is kept in heaps, so that it costs O(log n) per lock
+   in a chain however many threads are involved.  WAITERS is a
+   heap of threads by priority, and a thread's held_locks is a
+   heap of the locks it holds that have waiters, by the priority
+   of their greatest waiter, which each lock caches in PRIORITY.
+   A thread's priority is then the greater of its own and that of
+   the greatest lock in held_locks. */
 void
 lock_init (struct lock *lock) {
 	ASSERT (lock != NULL);
 
 	lock->holder = NULL;
-	sema_init (&lock->semaphore, 1);
+	lock->contended = false;
+	waitq_init (&lock->waiters);
+	lock->priority = PRI_MIN;
+	lock->donee = NULL;
+	lock->stat = NULL;
+	if (lockstat_enabled)
+		lock->stat = lockstat_class (NULL, __builtin_return_address (0));
+}
+
+/* Gives LOCK the name NAME in the -lockstat report.  Locks with
+   the same name share statistics, and NAME must stay valid, so
+   it is usually a string literal. */
+void
+lock_set_name (struct lock *lock, const char *name) {
+	ASSERT (lock != NULL);
+	ASSERT (name != NULL);
+
+	if (lockstat_enabled)
+		lock->stat = lockstat_class (name, NULL);
+}
+
+/* Atomically sets LOCK's holder to T if LOCK is free.  Returns
+   true if successful, false if LOCK is held.  `lock cmpxchg' is
+   also a full memory barrier.  See [IA32-v2a] "CMPXCHG". */
+static inline bool
+lock_take (struct lock *lock, struct thread *t) {
+	struct thread *prev;
+
+	asm volatile ("lock cmpxchgq %2, %1"
+			: "=a" (prev), "+m" (lock->holder)
+			: "r" (t), "0" (NULL)
+			: "memory", "cc");
+	return prev == NULL;
+}
+
+/* Atomically marks LOCK free.  `xchg' with a memory operand is
+   also a full memory barrier.  See [IA32-v2b] "XCHG". */
+static inline void
+lock_drop (struct lock *lock) {
+	struct thread *prev = NULL;
+
+	asm volatile ("xchgq %0, %1" : "+r" (prev), "+m" (lock->holder)
+			: : "memory");
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -199,47 +375,87 @@ lock_acquire (struct lock *lock) {
 	ASSERT (!lock_held_by_current_thread (lock));
 
 	struct thread *curr = thread_current();
-    if (lock->holder != NULL) // 이미 점유중인 락이라면
-    {
-        curr->wait_on_lock = lock; // 현재 스레드의 wait_on_lock으로 지정
-        // lock holder의 donors list에 현재 스레드 추가
-        list_insert_ordered(&lock->holder->donations, &curr->donation_elem, cmp_donation_priority, NULL);
-        donate_priority(); // 현재 스레드의 priority를 lock holder에게 상속해줌
-    }
-
-	sema_down (&lock->semaphore);
-	curr->wait_on_lock = NULL;
-	lock->holder = thread_current ();
-}
+	uint64_t wait_start = 0;
 
-bool cmp_donation_priority(const struct list_elem *a,
-                            const struct list_elem *b, void *aux UNUSED)
-{
-    struct thread *st_a = list_entry(a, struct thread, donation_elem);
-    struct thread *st_b = list_entry(b, struct thread, donation_elem);
-    return st_a->priority > st_b->priority;
-}
+	/* Fast path: the lock is free. */
+	if (lock_take (lock, curr)) {
+		if (lock->stat != NULL)
+			lockstat_acquired (lock->stat, &lock->acquire_tsc, false, 0);
+		return;
+	}
 
-void remove_donor(struct lock *lock)
-{
-    struct list *donations = &(thread_current()->donations); // 현재 스레드의 donations
-    struct list_elem *donor_elem;	// 현재 스레드의 donations의 요소
-    struct thread *donor_thread;
+	if (lock->stat != NULL)
+		wait_start = rdtsc ();
+	enum intr_level old_level = synch_enter ();
+	for (;;) {
+		struct thread *holder;
+
+		/* Announce ourselves before trying again, so that a holder
+		   that releases from now on takes the slow path and wakes
+		   us up. */
+		lock->contended = true;
+		if (lock_take (lock, curr))
+			break;
+
+		/* The holder may have just dropped the lock on another
+		   CPU, so read it only once. */
+		holder = lock->holder;
+		if (holder == NULL)
+			continue;
+
+		curr->wait_on_lock = lock; // 현재 스레드의 wait_on_lock으로 지정
+		if (lock->stat != NULL && holder->priority < curr->priority)
+			lock->stat->donation_cnt++;
+		waitq_push (&lock->waiters, curr);
+		donate_priority(); // 현재 스레드의 priority를 lock holder에게 상속해줌
+		thread_block_locked (&synch_lock);
+	}
+	curr->wait_on_lock = NULL;
 
-    if (list_empty(donations))
-        return;
+	/* The rest of the waiters donate to us now. */
+	if (lock_update_donee (lock) != NULL)
+		update_priority_for_donations ();
+	if (lock->stat != NULL)
+		lockstat_acquired (lock->stat, &lock->acquire_tsc, true,
+				rdtsc () - wait_start);
+	synch_exit (old_level);
+}
 
-    donor_elem = list_front(donations);
+/* Returns true if the greatest waiter for the lock A has lower
+   priority than that of lock B.  Orders threads' held_locks. */
+bool
+lock_priority_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct lock, held_elem)->priority
+		< heap_entry (b, struct lock, held_elem)->priority;
+}
 
-    while (1)
-    {
-        donor_thread = list_entry(donor_elem, struct thread, donation_elem);
-        if (donor_thread->wait_on_lock == lock)		   // 현재 release될 lock을 기다리던 스레드라면
-            list_remove(&donor_thread->donation_elem); // 목록에서 제거
-        donor_elem = list_next(donor_elem);
-        if (donor_elem == list_end(donations))
-            return;
-    }
+/* Brings LOCK's cached priority up to date with its waiters, and
+   moves LOCK into its current holder's held_locks if it has
+   waiters, or out of its donee's held_locks otherwise.  Returns
+   the holder if it is now the donee, otherwise a null pointer.
+   synch_lock must be held. */
+static struct thread *
+lock_update_donee (struct lock *lock) {
+	struct thread *holder = lock->holder;
+
+	if (waitq_empty (&lock->waiters))
+		holder = NULL;
+	if (lock->donee != NULL && lock->donee != holder) {
+		heap_remove (&lock->donee->held_locks, &lock->held_elem);
+		lock->donee = NULL;
+	}
+	if (holder == NULL)
+		return NULL;
+
+	lock->priority = waitq_max (&lock->waiters)->priority;
+	if (lock->donee == holder)
+		heap_update (&holder->held_locks, &lock->held_elem);
+	else {
+		heap_insert (&holder->held_locks, &lock->held_elem);
+		lock->donee = holder;
+	}
+	return holder;
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -250,15 +466,14 @@ void remove_donor(struct lock *lock)
    interrupt handler. */
 bool
 lock_try_acquire (struct lock *lock) {
-	bool success;
-
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
-	success = sema_try_down (&lock->semaphore);
-	if (success)
-		lock->holder = thread_current ();
-	return success;
+	if (!lock_take (lock, thread_current ()))
+		return false;
+	if (lock->stat != NULL)
+		lockstat_acquired (lock->stat, &lock->acquire_tsc, false, 0);
+	return true;
 }
 
 /* Releases LOCK, which must be owned by the current thread.
@@ -272,11 +487,34 @@ lock_release (struct lock *lock) {
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
-	remove_donor(lock);
+	if (lock->stat != NULL)
+		lockstat_released (lock->stat, lock->acquire_tsc);
+
+	/* Fast path: nobody has tried to wait, so nobody donated. */
+	lock_drop (lock);
+	if (!lock->contended)
+		return;
+
+	/* Donations are read and written by whichever CPU runs the
+	   donor, so update them under synch_lock. */
+	enum intr_level old_level = synch_enter ();
+	if (lock->donee == thread_current ()) {
+		heap_remove (&lock->donee->held_locks, &lock->held_elem);
+		lock->donee = NULL;
+	}
     update_priority_for_donations();
 
-	lock->holder = NULL;
-	sema_up (&lock->semaphore);
+	/* The woken waiter no longer waits on LOCK, even before it
+	   runs, so donations to it must not reach LOCK's waiters. */
+	if (!waitq_empty (&lock->waiters)) { // 대기 중인 스레드를 깨움
+		struct thread *t = waitq_pop (&lock->waiters);
+		t->wait_on_lock = NULL;
+		thread_unblock (t);
+	}
+	if (waitq_empty (&lock->waiters))
+		lock->contended = false;
+	synch_exit (old_level);
+	preempt_priority ();
 
 	// thread_yield();
 }
@@ -290,13 +528,130 @@ lock_held_by_current_thread (const struct lock *lock) {
 
 	return lock->holder == thread_current ();
 }
-
-/* One semaphore in a list. */
-struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
-	struct semaphore semaphore;         /* This semaphore. */
-};
 
+/* Lock statistics.
+
+   With -lockstat, lock_init() points each lock at a class in
+   lock_stats, chosen by its caller's address, and lock_set_name()
+   can move it to a named class instead.  Spin locks are only
+   counted once spin_set_name() gives them a class, since most of
+   them sit on paths that the statistics would slow down.
+
+   Locks are often embedded in memory that is later freed, so
+   statistics live in the class rather than the lock.  The
+   classes are only written under lockstat_lock, which is taken
+   last, so that the slow paths can record statistics with
+   synch_lock or a named spin lock held. */
+#define LOCK_STAT_CNT 128       /* Most lock classes. */
+#define LOCK_STAT_TOP 20        /* Classes printed. */
+
+bool lockstat_enabled;
+static struct lock_stat lock_stats[LOCK_STAT_CNT];
+static int lock_stat_cnt;
+static struct spinlock lockstat_lock;
+
+/* Returns the class named NAME, or if NAME is null the unnamed
+   class for SITE, creating it if necessary.  Returns a null
+   pointer if there is no room for another class. */
+static struct lock_stat *
+lockstat_class (const char *name, void *site) {
+	struct lock_stat *s = NULL;
+	enum intr_level old_level = intr_disable ();
+	int i;
+
+	spin_lock (&lockstat_lock);
+	for (i = 0; i < lock_stat_cnt; i++) {
+		struct lock_stat *t = &lock_stats[i];
+		if (name != NULL ? t->name != NULL && !strcmp (t->name, name)
+		                 : t->name == NULL && t->site == site) {
+			s = t;
+			break;
+		}
+	}
+	if (s == NULL && lock_stat_cnt < LOCK_STAT_CNT) {
+		s = &lock_stats[lock_stat_cnt++];
+		s->name = name;
+		s->site = site;
+	}
+	spin_unlock (&lockstat_lock);
+	intr_set_level (old_level);
+	return s;
+}
+
+/* Records an acquisition of a lock in class S, and if
+   CONTENDED, that it had to wait WAIT cycles first.  Stores the
+   time of acquisition in *ACQUIRE_TSC. */
+static void
+lockstat_acquired (struct lock_stat *s, uint64_t *acquire_tsc,
+		bool contended, uint64_t wait) {
+	enum intr_level old_level = intr_disable ();
+
+	spin_lock (&lockstat_lock);
+	s->acquired_cnt++;
+	if (contended) {
+		s->contended_cnt++;
+		s->wait_total += wait;
+		if (wait > s->wait_max)
+			s->wait_max = wait;
+	}
+	*acquire_tsc = rdtsc ();
+	spin_unlock (&lockstat_lock);
+	intr_set_level (old_level);
+}
+
+/* Records that the holder of a lock in class S, acquired at
+   ACQUIRE_TSC, is about to release it. */
+static void
+lockstat_released (struct lock_stat *s, uint64_t acquire_tsc) {
+	enum intr_level old_level = intr_disable ();
+	uint64_t hold = rdtsc () - acquire_tsc;
+
+	spin_lock (&lockstat_lock);
+	s->hold_total += hold;
+	if (hold > s->hold_max)
+		s->hold_max = hold;
+	spin_unlock (&lockstat_lock);
+	intr_set_level (old_level);
+}
+
+/* Prints the LOCK_STAT_TOP lock classes with the most total
+   waiting time.  Unnamed classes are shown by the address that
+   initialized them, which the `backtrace' program can turn into
+   a source line. */
+void
+lock_print_stats (void) {
+	bool printed[LOCK_STAT_CNT] = {false};
+	int i;
+
+	printf ("Lock statistics (cycles):\n");
+	printf ("%-20s %10s %10s %8s %14s %12s %14s %12s\n", "lock",
+			"acquired", "contended", "donated", "wait-total", "wait-max",
+			"hold-total", "hold-max");
+	for (i = 0; i < LOCK_STAT_TOP; i++) {
+		struct lock_stat *s, *max = NULL;
+		char site[20];
+
+		for (s = lock_stats; s < lock_stats + lock_stat_cnt; s++)
+			if (!printed[s - lock_stats] && s->acquired_cnt > 0
+					&& (max == NULL || s->wait_total > max->wait_total))
+				max = s;
+		if (max == NULL)
+			break;
+		printed[max - lock_stats] = true;
+
+		snprintf (site, sizeof site, "%p", max->site);
+		printf ("%-20s %10lld %10lld %8lld %14llu %12llu %14llu %12llu\n",
+				max->name != NULL ? max->name : site,
+				max->acquired_cnt, max->contended_cnt, max->donation_cnt,
+				(unsigned long long) max->wait_total,
+				(unsigned long long) max->wait_max,
+				(unsigned long long) max->hold_total,
+				(unsigned long long) max->hold_max);
+	}
+	if (lock_stat_cnt == LOCK_STAT_CNT)
+		printf ("(some locks not tracked: too many classes)\n");
+}
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -304,7 +659,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	waitq_init (&cond->waiters);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -329,18 +684,25 @@ cond_init (struct condition *cond) {
    we need to sleep. */
 void
 cond_wait (struct condition *cond, struct lock *lock) {
-	struct semaphore_elem waiter;
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	sema_init (&waiter.semaphore, 0);
-	// list_push_back (&cond->waiters, &waiter.elem);
-	list_insert_ordered (&cond->waiters, &waiter.elem, cmp_sema_priority, NULL);	// 수정!!!
+	old_level = synch_enter ();
+	waitq_push (&cond->waiters, curr); // priority 순으로 대기
+	spin_unlock (&synch_lock);
 	lock_release (lock);
-	sema_down (&waiter.semaphore);
+	spin_lock (&synch_lock);
+
+	/* A thread may have signaled us since we released LOCK, in
+	   which case cond_signal() took us out of COND's queue. */
+	while (curr->waitq == &cond->waiters)
+		thread_block_locked (&synch_lock);
+	synch_exit (old_level);
 	lock_acquire (lock);
 }
 
@@ -358,72 +720,85 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters))
-		list_sort (&cond->waiters, sema_priority_cmp, 0);
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
-}
-
-bool 
-sema_priority_cmp (const struct list_elem *l, const struct list_elem *s, void *aux UNUSED)
-{
-	struct semaphore_elem *l_sema = list_entry (l, struct semaphore_elem, elem);
-	struct semaphore_elem *s_sema = list_entry (s, struct semaphore_elem, elem);
+	enum intr_level old_level = synch_enter ();
+	bool signaled = false;
 
-	struct list *waiter_l_sema = &(l_sema->semaphore.waiters);
-	struct list *waiter_s_sema = &(s_sema->semaphore.waiters);
+	if (!waitq_empty (&cond->waiters)) {
+		struct thread *t = waitq_pop (&cond->waiters);
 
-	return list_entry (list_begin (waiter_l_sema), struct thread, elem)->priority
-		 > list_entry (list_begin (waiter_s_sema), struct thread, elem)->priority;
+		/* T is still running or ready, not blocked, if it has not
+		   yet blocked in cond_wait().  A thread only blocks with
+		   synch_lock held, so T's status cannot change under us. */
+		if (t->status == THREAD_BLOCKED)
+			thread_unblock (t);
+		signaled = true;
+	}
+	synch_exit (old_level);
+	if (signaled)
+		preempt_priority ();
 }
 
-
 // 현재 스레드가 원하는 락을 가진 holder에게 현재 스레드의 priority 상속
 void donate_priority(void)
 {
-    struct thread *curr = thread_current(); // 검사중인 스레드
-    struct thread *holder;					// curr이 원하는 락을 가진드스레드
-
-    int priority = curr->priority;
+    donate_chain(thread_current(), 0);
+}
 
-    for (int i = 0; i < 8; i++)
-    {
-        if (curr->wait_on_lock == NULL) // 더이상 중첩되지 않았으면 종료
-            return;
-        holder = curr->wait_on_lock->holder;
-        holder->priority = priority;
-        curr = holder;
-    }
+/* Passes on the priority of T, which has just started waiting or
+   whose priority has just gone up, to whatever T waits for, and
+   from there along the chain.  DEPTH is the length of the chain
+   so far; like the original donate_priority(), it stops at 8.
+   synch_lock must be held. */
+static void
+donate_chain (struct thread *t, int depth) {
+	for (; depth < 8; depth++) {
+		struct lock *lock = t->wait_on_lock;
+		struct thread *holder;
+
+		if (t->wait_on_rwlock != NULL) {
+			rw_donate (t->wait_on_rwlock, t->priority, depth);
+			return;
+		}
+		if (lock == NULL) // 더이상 중첩되지 않았으면 종료
+			return;
+
+		/* T's place among LOCK's waiters is already up to date, so
+		   re-key LOCK among its holder's held locks. */
+		holder = lock_update_donee (lock);
+		if (holder == NULL || holder->priority >= lock->priority)
+			return;
+		thread_set_effective_priority (holder, lock->priority); // ready 상태면 큐도 옮김
+		t = holder;
+	}
 }
 
 void update_priority_for_donations(void)
 {
-    struct thread *curr = thread_current();
-    struct list *donations = &(thread_current()->donations);
-    struct thread *donations_root;
+    ASSERT (spin_held_by_current_cpu (&synch_lock));
 
-    if (list_empty(donations)) // donors가 없으면 (donor가 하나였던 경우)
-    {
-        curr->priority = curr->init_priority; // 최초의 priority로 변경
-        return;
-    }
+    struct thread *curr = thread_current();
+    int priority = curr->init_priority; // 최초의 priority
+    int donated = lock_donated_priority(curr); // 가진 lock의 waiter들이 준 priority
 
-    donations_root = list_entry(list_front(donations), struct thread, donation_elem);
-    curr->priority = donations_root->priority;
+    if (priority < donated)
+        priority = donated;
+    curr->priority = priority;
 }
 
-bool cmp_sema_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
-{
-	struct semaphore_elem *sema_a = list_entry(a, struct semaphore_elem, elem);
-	struct semaphore_elem *sema_b = list_entry(b, struct semaphore_elem, elem);
-
-	struct list *waiters_a = &(sema_a->semaphore.waiters);
-	struct list *waiters_b = &(sema_b->semaphore.waiters);
-
-	struct thread *root_a = list_entry(list_begin(waiters_a), struct thread, elem);
-	struct thread *root_b = list_entry(list_begin(waiters_b), struct thread, elem);
-
-	return root_a->priority > root_b->priority;
+/* Returns the greatest priority donated to T by the waiters for
+   the locks and reader-writer locks that it holds, or PRI_MIN if
+   there are none. */
+int
+lock_donated_priority (struct thread *t) {
+	int priority = rw_donated_priority (t);
+
+	if (!heap_empty (&t->held_locks)) { // 가진 lock 중 waiter의 priority가 가장 높은 lock
+		struct lock *top = heap_entry (heap_max (&t->held_locks),
+				struct lock, held_elem);
+		if (priority < top->priority)
+			priority = top->priority;
+	}
+	return priority;
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -437,6 +812,438 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 
-	while (!list_empty (&cond->waiters))
+	while (!waitq_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
+
+static struct rw_hold *rw_hold_find (struct thread *, const struct rwlock *);
+static void rw_hold_add (struct rwlock *, struct rw_hold *, struct thread *);
+static void rw_wait (struct rwlock *, bool writer);
+static bool rw_reader_first (const struct rwlock *);
+static void rw_admit (struct rwlock *, struct thread *);
+static void rw_grant (struct rwlock *);
+static void rw_release_common (struct rwlock *, struct rw_hold *);
+
+/* Initializes RW.  A reader-writer lock may be held by any number
+   of readers at once, or by a single writer.
+
+   A reader-writer lock is not recursive, and it is fair to
+   writers: once a writer is waiting, new readers queue up behind
+   it instead of joining the readers already inside.  Waiters are
+   handed the lock directly, highest priority first, and like
+   ordinary locks they donate their priority, here to every
+   current holder.  A writer that waits for a lock held by many
+   readers thus boosts all of them.  Readers and writers wait in
+   separate wait queues, and the lock takes whichever waiter
+   would come first if the two were merged.
+
+   Each holder takes up one of its thread's RW_HOLD_MAX struct
+   rw_holds for as long as it holds the lock. */
+void
+rw_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	rw->writer = NULL;
+	rw->reader_cnt = 0;
+	list_init (&rw->holders);
+	waitq_init (&rw->readers);
+	waitq_init (&rw->writers);
+	rw->upgrader = NULL;
+}
+
+/* Acquires RW for reading, sleeping while it is held by a writer
+   or a writer is waiting for it.  RW must not already be held by
+   the current thread.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_read_acquire (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!rw_held_by_current_thread (rw));
+
+	old_level = synch_enter ();
+	if (rw->writer == NULL && waitq_empty (&rw->writers)
+			&& rw->upgrader == NULL) {
+		rw->reader_cnt++;
+		rw_hold_add (rw, rw_hold_find (thread_current (), NULL),
+				thread_current ());
+	} else
+		rw_wait (rw, false);
+	synch_exit (old_level);
+}
+
+/* Releases RW, which the current thread must hold for reading. */
+void
+rw_read_release (struct rwlock *rw) {
+	enum intr_level old_level;
+	struct rw_hold *h;
+
+	ASSERT (rw != NULL);
+
+	old_level = synch_enter ();
+	h = rw_hold_find (thread_current (), rw);
+	ASSERT (h != NULL && rw->writer == NULL);
+	rw->reader_cnt--;
+	rw_release_common (rw, h);
+	synch_exit (old_level);
+	preempt_priority ();
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  RW must not already be held by the current thread.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_write_acquire (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!rw_held_by_current_thread (rw));
+
+	old_level = synch_enter ();
+	if (rw->writer == NULL && rw->reader_cnt == 0
+			&& waitq_empty (&rw->readers) && waitq_empty (&rw->writers)) {
+		rw->writer = thread_current ();
+		rw_hold_add (rw, rw_hold_find (thread_current (), NULL),
+				thread_current ());
+	} else
+		rw_wait (rw, true);
+	synch_exit (old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rw_write_release (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rw->writer == thread_current ());
+
+	old_level = synch_enter ();
+	rw->writer = NULL;
+	rw_release_common (rw, rw_hold_find (thread_current (), rw));
+	synch_exit (old_level);
+	preempt_priority ();
+}
+
+/* Turns the current thread's read hold on RW into a write hold,
+   waiting for the other readers to leave.  The upgrading thread
+   goes ahead of any waiting writer.  If another reader is
+   already waiting to upgrade, both would wait for each other
+   forever, so this returns false without waiting and the caller
+   still holds RW for reading.  Otherwise returns true.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+rw_upgrade (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = synch_enter ();
+	ASSERT (rw->writer == NULL && rw_hold_find (curr, rw) != NULL);
+	if (rw->upgrader != NULL) {
+		synch_exit (old_level);
+		return false;
+	}
+
+	if (rw->reader_cnt == 1) {
+		rw->reader_cnt = 0;
+		rw->writer = curr;
+	} else {
+		rw->upgrader = curr;
+		curr->wait_on_rwlock = rw;
+		rw_donate (rw, curr->priority, 0);
+		while (rw->writer != curr)
+			thread_block_locked (&synch_lock);
+		curr->wait_on_rwlock = NULL;
+	}
+	synch_exit (old_level);
+	return true;
+}
+
+/* Turns the current thread's write hold on RW into a read hold,
+   letting in the readers that are first in line. */
+void
+rw_downgrade (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rw->writer == thread_current ());
+
+	old_level = synch_enter ();
+	rw->writer = NULL;
+	rw->reader_cnt = 1;
+	rw_grant (rw);
+	synch_exit (old_level);
+	preempt_priority ();
+}
+
+/* Returns true if the current thread holds RW for reading or
+   writing, false otherwise. */
+bool
+rw_held_by_current_thread (const struct rwlock *rw) {
+	enum intr_level old_level;
+	bool held;
+
+	ASSERT (rw != NULL);
+
+	old_level = synch_enter ();
+	held = rw_hold_find (thread_current (), rw) != NULL;
+	synch_exit (old_level);
+	return held;
+}
+
+/* Returns T's hold on RW, or a free hold if RW is NULL.
+   synch_lock must be held. */
+static struct rw_hold *
+rw_hold_find (struct thread *t, const struct rwlock *rw) {
+	int i;
+
+	for (i = 0; i < RW_HOLD_MAX; i++)
+		if (t->rw_holds[i].rw == rw)
+			return &t->rw_holds[i];
+	ASSERT (rw != NULL); /* Too many reader-writer locks held. */
+	return NULL;
+}
+
+/* Records that T, whose free hold is H, now holds RW. */
+static void
+rw_hold_add (struct rwlock *rw, struct rw_hold *h, struct thread *t) {
+	h->rw = rw;
+	h->thread = t;
+	list_push_back (&rw->holders, &h->elem);
+}
+
+/* Makes the current thread wait until it is handed RW, for
+   writing if WRITER is true or for reading otherwise.  synch_lock
+   must be held. */
+static void
+rw_wait (struct rwlock *rw, bool writer) {
+	struct thread *curr = thread_current ();
+	struct waitq *wq = writer ? &rw->writers : &rw->readers;
+
+	/* Fail now, not in rw_admit(), if CURR has no free hold. */
+	rw_hold_find (curr, NULL);
+
+	waitq_push (wq, curr);
+	curr->wait_on_rwlock = rw;
+	rw_donate (rw, curr->priority, 0);
+
+	/* rw_admit() takes us out of WQ before unblocking us. */
+	while (curr->waitq == wq)
+		thread_block_locked (&synch_lock);
+}
+
+/* Returns true if the first waiting reader for RW should go
+   before the first waiting writer: it has higher priority, or the
+   same priority and arrived earlier.  False if no reader waits. */
+static bool
+rw_reader_first (const struct rwlock *rw) {
+	struct thread *r = waitq_max (&rw->readers);
+	struct thread *w = waitq_max (&rw->writers);
+
+	if (r == NULL || w == NULL)
+		return r != NULL;
+	if (r->priority != w->priority)
+		return r->priority > w->priority;
+	return (int) (r->wait_seq - w->wait_seq) < 0;
+}
+
+/* Gives T, just taken out of one of RW's wait queues, its hold
+   on RW and wakes it up. */
+static void
+rw_admit (struct rwlock *rw, struct thread *t) {
+	rw_hold_add (rw, rw_hold_find (t, NULL), t);
+	t->wait_on_rwlock = NULL;
+	thread_unblock (t);
+}
+
+/* Hands RW to as many waiters as can now have it: a pending
+   upgrade once its thread is the last reader, else the readers
+   that come before the first writer if no writer holds RW, else
+   the first writer if RW is free.  synch_lock must be held. */
+static void
+rw_grant (struct rwlock *rw) {
+	if (rw->upgrader != NULL) {
+		if (rw->reader_cnt == 1) {
+			rw->reader_cnt = 0;
+			rw->writer = rw->upgrader;
+			rw->upgrader = NULL;
+			rw->writer->wait_on_rwlock = NULL;
+			thread_unblock (rw->writer);
+		}
+		return;
+	}
+	if (rw->writer != NULL)
+		return;
+
+	while (rw_reader_first (rw)) {
+		rw->reader_cnt++;
+		rw_admit (rw, waitq_pop (&rw->readers));
+	}
+	if (rw->reader_cnt == 0 && !waitq_empty (&rw->writers)) {
+		rw->writer = waitq_pop (&rw->writers);
+		rw_admit (rw, rw->writer);
+	}
+}
+
+/* Drops the current thread's hold H on RW, after the caller has
+   updated RW's reader or writer, and passes RW on.  synch_lock
+   must be held; the caller checks for preemption after releasing
+   it. */
+static void
+rw_release_common (struct rwlock *rw, struct rw_hold *h) {
+	list_remove (&h->elem);
+	h->rw = NULL;
+	rw_grant (rw);
+	update_priority_for_donations ();
+}
+
+/* Donates PRIORITY to every holder of RW, and onward to whatever
+   they are waiting for.  DEPTH is the length of the donation
+   chain so far; like donate_priority(), it stops at 8. */
+static void
+rw_donate (struct rwlock *rw, int priority, int depth) {
+	struct list_elem *e;
+
+	for (e = list_begin (&rw->holders); e != list_end (&rw->holders);
+			e = list_next (e)) {
+		struct thread *t = list_entry (e, struct rw_hold, elem)->thread;
+
+		if (depth < 8 && t->priority < priority) {
+			thread_set_effective_priority (t, priority);
+			donate_chain (t, depth + 1);
+		}
+	}
+}
+
+/* Returns the highest priority among the threads waiting for the
+   reader-writer locks that T holds, or PRI_MIN if there are none.
+   Looks only at the head of each wait queue, so it takes
+   O(RW_HOLD_MAX) time however many threads wait.  synch_lock must
+   be held. */
+static int
+rw_donated_priority (struct thread *t) {
+	int priority = PRI_MIN;
+	int i;
+
+	for (i = 0; i < RW_HOLD_MAX; i++) {
+		struct rwlock *rw = t->rw_holds[i].rw;
+		struct thread *w;
+
+		if (rw == NULL)
+			continue;
+		if (rw->upgrader != NULL && rw->upgrader != t
+				&& rw->upgrader->priority > priority)
+			priority = rw->upgrader->priority;
+		w = waitq_max (&rw->readers);
+		if (w != NULL && w->priority > priority)
+			priority = w->priority;
+		w = waitq_max (&rw->writers);
+		if (w != NULL && w->priority > priority)
+			priority = w->priority;
+	}
+	return priority;
+}
+
+/* Initializes spin lock SL as not held. */
+void
+spin_init (struct spinlock *sl) {
+	ASSERT (sl != NULL);
+
+	sl->locked = 0;
+	sl->cpu = NULL;
+	sl->stat = NULL;
+}
+
+/* Gives SL the name NAME in the -lockstat report, and starts
+   keeping statistics for it.  Spin locks and locks with the same
+   name share statistics, and NAME must stay valid, so it is
+   usually a string literal. */
+void
+spin_set_name (struct spinlock *sl, const char *name) {
+	ASSERT (sl != NULL);
+	ASSERT (name != NULL);
+
+	if (lockstat_enabled)
+		sl->stat = lockstat_class (name, NULL);
+}
+
+/* Acquires SL, spinning until it becomes available.  Interrupts
+   must be off, and SL must not already be held by the current
+   CPU. */
+void
+spin_lock (struct spinlock *sl) {
+	uint64_t wait_start = 0;
+	bool contended = false;
+
+	ASSERT (sl != NULL);
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (!spin_held_by_current_cpu (sl));
+
+	if (!spin_try_lock (sl)) {
+		if (sl->stat != NULL)
+			wait_start = rdtsc ();
+
+		/* Spin on a plain read, so that waiting CPUs do not keep
+		   stealing the cache line from the holder. */
+		do
+			while (sl->locked)
+				asm volatile ("pause");
+		while (!spin_try_lock (sl));
+		contended = true;
+	}
+	if (sl->stat != NULL)
+		lockstat_acquired (sl->stat, &sl->acquire_tsc, contended,
+				contended ? rdtsc () - wait_start : 0);
+}
+
+/* Tries to acquire SL and returns true if successful or false
+   on failure.  Interrupts must be off. */
+bool
+spin_try_lock (struct spinlock *sl) {
+	int locked = 1;
+
+	ASSERT (sl != NULL);
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* `xchg' with a memory operand is atomic and a full memory
+	   barrier.  See [IA32-v2b] "XCHG". */
+	asm volatile ("xchgl %0, %1" : "+r" (locked), "+m" (sl->locked)
+			: : "memory");
+	if (locked)
+		return false;
+	sl->cpu = cpu_current ();
+	return true;
+}
+
+/* Releases SL, which must be held by the current CPU. */
+void
+spin_unlock (struct spinlock *sl) {
+	ASSERT (sl != NULL);
+	ASSERT (spin_held_by_current_cpu (sl));
+
+	if (sl->stat != NULL)
+		lockstat_released (sl->stat, sl->acquire_tsc);
+	sl->cpu = NULL;
+	barrier ();
+	sl->locked = 0;
+}
+
+/* Returns true if the current CPU holds SL, false otherwise. */
+bool
+spin_held_by_current_cpu (const struct spinlock *sl) {
+	ASSERT (sl != NULL);
+
+	return sl->locked && sl->cpu == cpu_current ();
+}
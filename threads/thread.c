@@ -4,12 +4,18 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/rcu.h"
+#include "threads/schedtrace.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "threads/vmalloc.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -29,16 +35,48 @@
    기본 스레드에 대한 임의 값 이 값을 수정하지 마십시오. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running.
+/* Each CPU has its own run queue of processes in THREAD_READY
+   state, that is, processes that are ready to run but not
+   actually running.  There is one FIFO list per priority level
+   and a bitmap of the nonempty ones; see struct cpu.  A CPU that
+   runs out of work steals from the other CPUs' run queues.
+
+   Each run queue is protected by its CPU's rq_lock.  Locks are
+   taken in this order: a subsystem's own lock (sleep_lock, a
+   device lock, ...), then synch_lock, then a run queue lock,
+   then leaf locks that are never held while taking another.  At
+   most one run queue lock is held at a time, except that
+   next_thread_to_run() may try, without waiting, for a second.
 
    TRADE_READY 상태의 프로세스,
-   즉 실행 준비가 되었지만 실제로 실행되지 않는 프로세스의 목록입니다. */
-static struct list ready_list;
-static struct list sleep_list; // 재울 애들을 저장
+   즉 실행 준비가 되었지만 실제로 실행되지 않는 프로세스의 목록입니다.
+   우선순위마다 FIFO 리스트 하나, 비어있지 않은 리스트는 bitmap에 표시. */
+#if PRI_MAX - PRI_MIN >= 64
+#error ready_bitmap requires at most 64 priority levels
+#endif
+
+/* Threads blocked in thread_sleep(), keyed on their wake tick.
+   재울 애들을 저장 */
+static struct wheel sleep_wheel;
+
+/* Protects sleep_wheel and slack_sleepers. */
+static struct spinlock sleep_lock;
+
+/* Threads in sleep_wheel that are past their earliest wake tick
+   but not yet at their deadline.  They are woken with the next
+   batch of sleepers that must wake, so that threads with loose
+   deadlines share one wake pass instead of each taking its own. */
+static struct list slack_sleepers;
 
-/* Idle thread. */
-static struct thread *idle_thread;
+/* Number of calls to thread_wake() that woke some thread.
+   Protected by sleep_lock. */
+static long long wake_pass_cnt;
+
+/* A call to thread_wake(). */
+struct wake_pass {
+	int64_t tick;               /* Tick being processed. */
+	int woken_cnt;              /* Threads woken at their deadline. */
+};
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
@@ -46,25 +84,60 @@ static struct thread *initial_thread;
 /* Lock used by allocate_tid(). - allocate_tid()에서 사용한 Lock */
 static struct lock tid_lock;
 
-/* Thread destruction requests - 스레드 삭제 요청 */
-// 쓰레드 파괴 요청들이 담기는 list
-// 한번에 하나밖에 못함 -> 파괴도 하나씩?
-static struct list destruction_req;
-
-/* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
+/* Pages of dead threads, kept for reuse by thread_create() so
+   that creating a thread does not have to go to the page
+   allocator and zero a whole page.  At most THREAD_CACHE_MAX
+   pages are kept; the rest go back to palloc. */
+#define THREAD_CACHE_MAX 16
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+static struct spinlock thread_cache_lock;
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
+
+/* Most of each CPU's time that EDF threads may reserve, in
+   millionths.  The rest is left for the other threads. */
+#define EDF_UTIL_MAX 950000
+
+/* Multi-level feedback queue scheduler.  load_avg is the system
+   load average, and mlfqs_seconds the number of times that
+   recent_cpu has decayed, once a second, since boot.  The decay
+   factor depends on the load average at the time, so the load
+   average that the N'th decay used is kept in
+   load_history[N % MLFQS_HISTORY], for threads that catch up
+   later.  See mlfqs_catch_up(). */
+#define MLFQS_HISTORY 64
+#define MLFQS_REFRESH_BATCH 8   /* Ready threads refreshed per lock hold. */
+static fixed_t load_avg;
+static int64_t mlfqs_seconds;
+static fixed_t load_history[MLFQS_HISTORY];
+
+/* Refreshes the priorities of ready threads after each decay. */
+static struct work mlfqs_work;
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, switch threads through a full interrupt frame.  See
+   thread_launch(). */
+bool thread_switch_iret;
+
+/* If true, do not reuse the pages of dead threads.  See
+   thread_page_get(). */
+bool thread_cache_disabled;
+
+/* If true, print CPU accounting for each thread as it exits.
+   See thread_get_stats(). */
+bool thread_stats_on_exit;
+
+/* Thread switch routines, in switch.S. */
+void switch_context (uint64_t *save_rsp, uint64_t next_rsp);
+void switch_to_frame (uint64_t *save_rsp, struct intr_frame *tf);
+void thread_switch_resume (struct thread *) NO_RETURN;
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -72,8 +145,38 @@ static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
+static void schedule_tail (void);
+static struct cpu *thread_rq_lock (struct thread *);
+static bool thread_preempts (struct cpu *, struct thread *);
+static bool set_priority_locked (struct cpu *, struct thread *, int priority);
+static void thread_launch_iret (struct thread *curr, struct thread *th);
+static struct thread *thread_page_get (void);
+static void thread_page_put (struct thread *);
 static tid_t allocate_tid (void);
-bool cmp(struct list_elem *state_a, struct list_elem *state_b, void *aux UNUSED);
+static void ready_queue_push (struct cpu *, struct thread *);
+static void ready_queue_remove (struct thread *);
+static struct thread *ready_queue_pop (struct cpu *);
+static void wake_sleeper (struct wheel_elem *, void *aux);
+static void acct_switch (struct thread *curr, struct thread *next);
+static void print_thread_stats (struct thread *);
+static void edf_next_period (struct thread *);
+static void edf_wakeup (struct thread *);
+static void mlfqs_tick (struct thread *, struct cpu *);
+static void mlfqs_second (void);
+static void mlfqs_catch_up (struct thread *);
+static int mlfqs_priority (struct thread *);
+static void mlfqs_refresh (struct thread *);
+static void mlfqs_refresh_ready (void *aux);
+static bool mlfqs_refresh_batch (struct cpu *, bool *resched);
+
+/* Returns the index of the most significant set bit in X,
+   which must be nonzero.  See [IA32-v2a] "BSR". */
+static inline int
+highest_bit (uint64_t x) {
+	uint64_t bit;
+	asm ("bsrq %1, %0" : "=r" (bit) : "rm" (x) : "cc");
+	return bit;
+}
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -154,15 +257,66 @@ thread_init (void) {
 
 	/* Init the globla thread context - 글로벌 스레드 컨텍스트를 초기화하십시오 */
 	lock_init (&tid_lock);
-	list_init (&ready_list);		// 실행 준비가 되었지만 실제로 실행되지 않는 프로세스의 목록을 초기화
-	list_init (&sleep_list);
-	list_init (&destruction_req);	// 스레드 삭제 요청하는 목록을 초기화
+	lock_set_name (&tid_lock, "tid_lock");
+	cpu_init (&cpus[0], 0, 0);	// BSP의 실행 대기열 초기화
+	wheel_init (&sleep_wheel, 0);
+	list_init (&slack_sleepers);
+	spin_init (&sleep_lock);
+	list_init (&thread_cache);
+	spin_init (&thread_cache_lock);
+	work_init (&mlfqs_work, mlfqs_refresh_ready, NULL);
 
 	/* Set up a thread structure for the running thread. - 실행 중인 스레드에 대한 스레드 구조 설정 */
 	initial_thread = running_thread ();		// 실행 중인 스레드를 반환
 	init_thread (initial_thread, "main", PRI_DEFAULT);	// "main"이라는 이름과 priority가 31인 Thread 구조체 t를 초기화 
 	initial_thread->status = THREAD_RUNNING;	// 실행 중
 	initial_thread->tid = allocate_tid ();	// 새로운 스레드에 사용할 스레드 ID(tid)를 반환해서 initial_thread->tid 값에 저장
+	initial_thread->cpu = &cpus[0];
+	cpus[0].curr = initial_thread;
+}
+
+/* Allocates and initializes the thread that application
+   processor C starts on.  Once C is up, the thread becomes C's
+   idle thread.  Returns a null pointer if memory is short. */
+struct thread *
+thread_alloc_ap (struct cpu *c) {
+	struct thread *t;
+	char name[16];
+
+	t = thread_page_get ();
+	if (t == NULL)
+		return NULL;
+
+	snprintf (name, sizeof name, "idle%d", c->id);
+	init_thread (t, name, PRI_MIN);
+	t->tid = allocate_tid ();
+	t->status = THREAD_RUNNING;
+	t->cpu = c;
+	c->idle_thread = c->curr = t;
+	return t;
+}
+
+/* Loads the GDT on an application processor.  Like
+   thread_init(), this must run before anything else. */
+void
+thread_init_ap (void) {
+	struct desc_ptr gdt_ds = {
+		.size = sizeof (gdt) - 1,
+		.address = (uint64_t) gdt
+	};
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	lgdt (&gdt_ds);
+}
+
+/* Runs the idle loop on an application processor, which picks up
+   work as it appears in run queues.  Called once the processor
+   is fully set up, with interrupts off. */
+void
+thread_start_ap (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	idle (NULL);
+	NOT_REACHED ();
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -190,27 +344,175 @@ thread_start (void) {
 void
 thread_tick (void) {
 	struct thread *t = thread_current ();
+	struct cpu *c = cpu_current ();
+
+	c->ticks++;
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	if (t == c->idle_thread)
+		c->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		c->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
+		c->kernel_ticks++;
+
+	/* Enforce the EDF budget: once it is spent, the thread waits
+	   for its next period.  See thread_yield(). */
+	if (t->edf && --t->edf_budget <= 0) {
+		t->edf_throttled = true;
+		intr_yield_on_return ();
+	}
+
+	if (thread_mlfqs)
+		mlfqs_tick (t, c);
+
+	rcu_tick ();
+	vmalloc_tick ();
 
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (++c->thread_ticks >= TIME_SLICE)
 		intr_yield_on_return ();
 }
 
-/* Prints thread statistics. */
+/* Prints thread statistics, summed over all CPUs and then, if
+   there is more than one, for each CPU. */
 void
 thread_print_stats (void) {
+	long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++) {
+		idle_ticks += cpus[i].idle_ticks;
+		kernel_ticks += cpus[i].kernel_ticks;
+		user_ticks += cpus[i].user_ticks;
+	}
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 			idle_ticks, kernel_ticks, user_ticks);
+	if (cpu_cnt > 1)
+		for (i = 0; i < cpu_cnt; i++)
+			printf ("CPU %d: %lld idle ticks, %lld kernel ticks, "
+					"%lld threads stolen\n", i, cpus[i].idle_ticks,
+					cpus[i].kernel_ticks, cpus[i].steal_cnt);
+}
+
+/* Returns the number of thread switches made so far, on all
+   CPUs. */
+long long
+thread_switch_cnt (void) {
+	long long switch_cnt = 0;
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++)
+		switch_cnt += cpus[i].switch_cnt;
+	return switch_cnt;
+}
+
+/* Returns the number of timer ticks so far at which some
+   sleeping thread was woken. */
+long long
+thread_wake_pass_cnt (void) {
+	enum intr_level old_level;
+	long long cnt;
+
+	old_level = intr_disable ();
+	spin_lock (&sleep_lock);
+	cnt = wake_pass_cnt;
+	spin_unlock (&sleep_lock);
+	intr_set_level (old_level);
+	return cnt;
+}
+
+/* Per-thread CPU accounting.
+
+   Each thread's time is split into intervals at every thread
+   switch and every crossing between user mode and the kernel,
+   and the length of each interval, measured with the time stamp
+   counter, is added to the thread's user or kernel cycles.
+   acct_tsc is the start of the current interval.  Unlike the
+   per-CPU tick counts above, this is exact to a few cycles, and
+   it also catches threads that run for less than a tick. */
+
+/* Called on entry to the kernel from user mode: the interval
+   that ends here was spent in user mode. */
+void
+thread_acct_enter_kernel (void) {
+	struct thread *t = thread_current ();
+	uint64_t now = rdtsc ();
+
+	t->stats.user_cycles += now - t->acct_tsc;
+	t->acct_tsc = now;
+}
+
+/* Called just before returning to user mode: the interval that
+   ends here was spent in the kernel. */
+void
+thread_acct_exit_kernel (void) {
+	struct thread *t = thread_current ();
+	uint64_t now = rdtsc ();
+
+	t->stats.kernel_cycles += now - t->acct_tsc;
+	t->acct_tsc = now;
+}
+
+/* Copies the running thread's CPU accounting, up to now, into
+   *STATS. */
+void
+thread_get_stats (struct thread_stats *stats) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	thread_acct_exit_kernel ();
+	*stats = t->stats;
+	intr_set_level (old_level);
+}
+
+/* Accounts for a switch from CURR to NEXT, in schedule(): ends
+   CURR's kernel interval, counts the switch, and records how
+   long NEXT waited in a run queue. */
+static void
+acct_switch (struct thread *curr, struct thread *next) {
+	uint64_t now = rdtsc ();
+
+	curr->stats.kernel_cycles += now - curr->acct_tsc;
+	if (curr->status == THREAD_BLOCKED)
+		curr->stats.voluntary_switches++;
+	else if (curr->status == THREAD_READY)
+		curr->stats.involuntary_switches++;
+
+	if (next->ready_tsc != 0) {
+		uint64_t wait = now - next->ready_tsc;
+		int b = wait != 0 ? highest_bit (wait) : 0;
+
+		if (b >= THREAD_STATS_BUCKETS)
+			b = THREAD_STATS_BUCKETS - 1;
+		next->stats.rq_wait_hist[b]++;
+		next->ready_tsc = 0;
+	}
+	next->acct_tsc = now;
+}
+
+/* Prints T's CPU accounting, with the nonempty buckets of its
+   run queue wait histogram as log2(cycles):count pairs.  T must
+   be the running thread. */
+static void
+print_thread_stats (struct thread *t) {
+	struct thread_stats stats;
+	int b;
+
+	thread_get_stats (&stats);
+	printf ("%s (tid %d): %llu user cycles, %llu kernel cycles, "
+			"%llu voluntary and %llu involuntary switches, run queue wait",
+			t->name, t->tid, (unsigned long long) stats.user_cycles,
+			(unsigned long long) stats.kernel_cycles,
+			(unsigned long long) stats.voluntary_switches,
+			(unsigned long long) stats.involuntary_switches);
+	for (b = 0; b < THREAD_STATS_BUCKETS; b++)
+		if (stats.rq_wait_hist[b] != 0)
+			printf (" %d:%u", b, stats.rq_wait_hist[b]);
+	printf ("\n");
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -253,7 +555,7 @@ thread_create (const char *name, int priority,
 	ASSERT (function != NULL);
 
 	/* Allocate thread. - 스레드 할당 */
-	t = palloc_get_page (PAL_ZERO);
+	t = thread_page_get ();
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -261,6 +563,24 @@ thread_create (const char *name, int priority,
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
 
+	/* Under the MLFQS, PRIORITY is ignored: the new thread starts
+	   with its parent's nice and recent_cpu, and gets its
+	   priority from them in thread_unblock().  The exception is a
+	   thread created at PRI_MAX, such as a workqueue worker, which
+	   keeps PRI_MAX so that kernel services are not aged behind
+	   the threads that they serve. */
+	if (thread_mlfqs) {
+		struct thread *curr = thread_current ();
+		enum intr_level old_level = synch_enter ();
+
+		mlfqs_catch_up (curr);
+		t->nice = curr->nice;
+		t->recent_cpu = curr->recent_cpu;
+		t->mlfqs_stamp = mlfqs_seconds;
+		t->mlfqs_fixed = priority == PRI_MAX;
+		synch_exit (old_level);
+	}
+
 	/* Call the kernel_thread if it scheduled.
 	   Note) rdi is 1st argument, and rsi is 2nd argument.
 
@@ -273,42 +593,57 @@ thread_create (const char *name, int priority,
 	t->tf.es = SEL_KDSEG;
 	t->tf.ss = SEL_KDSEG;
 	t->tf.cs = SEL_KCSEG;
-	t->tf.eflags = FLAG_IF;
+	/* Start out with interrupts off, as the thread switching to
+	   it left them; kernel_thread() turns them on. */
+	t->tf.eflags = FLAG_MBS;
 
 	/* Add to run queue. - 실행 대기열에 추가 */
 	thread_unblock (t);
 
-	// ready_list 추가 이후에, ready_list 맨 앞에 있는 쓰레드랑, 현재 러닝중인 쓰레드 비교
+	// 레디 큐 추가 이후에, 레디 큐에서 가장 높은 우선순위 쓰레드랑, 현재 러닝중인 쓰레드 비교
 	preempt_priority();
 
 	return tid;
 }
 
-// ready_list 비어 있는 지 확인, thread_current()->priority, list_entry(list_front(&ready_list), thread, elem); 
-// yield ()	// 수정!!
-void thread_test_preemption(void)
-{
-    if (!list_empty(&ready_list) && thread_current()->priority 
-        < list_entry(list_front(&ready_list), struct thread, elem)->priority)
-        thread_yield();
-}
-
 /* Puts the current thread to sleep.  It will not be scheduled
    again until awoken by thread_unblock().
 
-   This function must be called with interrupts turned off.  It
-   is usually a better idea to use one of the synchronization
-   primitives in synch.h. */
+   This function must be called with interrupts turned off, and
+   is only safe where no other CPU can wake the thread, as for the
+   idle thread.  Otherwise use thread_block_locked(), or better,
+   one of the synchronization primitives in synch.h. */
 
 // 현재 돌고 있는 러닝 쓰레드의 상태를 블록으로 바꿔준다. 스케줄링까지 해줌 -> 레디큐의 우선순위 높은 걸 러닝쓰레드로 바꿔준다.
 // 인터럽트 플래그는 다양한 상황에서 사용되며, 특히 공유 데이터에 대한 접근 동기화와 스레드 스케줄링에 영향을 미칩니다.
 // 인터럽트를 잠시 비활성화하여 크리티컬 섹션에 안전하게 접근하거나, 스레드 간의 상호배제를 구현하는 데 사용
 void
 thread_block (void) {
+	thread_block_locked (NULL);
+}
+
+/* Puts the current thread to sleep, like thread_block(), and
+   releases GUARD, the spin lock that protects whatever the thread
+   is waiting for, once it is marked blocked.  A waker must hold
+   GUARD to find the thread, so it cannot call thread_unblock()
+   before the thread has blocked.  GUARD is held again when this
+   function returns.  GUARD may be null. */
+void
+thread_block_locked (struct spinlock *guard) {
+	struct thread *curr = thread_current ();
+	struct cpu *c = cpu_current ();
+
 	ASSERT (!intr_context ());	// 외부 인터럽트를 처리하고 있지 않으면 True, 
 	ASSERT (intr_get_level () == INTR_OFF); // 인터럽트가 OFF 상태면, 
-	thread_current ()->status = THREAD_BLOCKED; // 현재 러닝중인 쓰레드 상태를 블록으로 바꿔준다.
+
+	spin_lock (&c->rq_lock);
+	sched_trace (curr, THREAD_RUNNING, THREAD_BLOCKED, ST_BLOCK);
+	curr->status = THREAD_BLOCKED; // 현재 러닝중인 쓰레드 상태를 블록으로 바꿔준다.
+	if (guard != NULL)
+		spin_unlock (guard);
 	schedule ();
+	if (guard != NULL)
+		spin_lock (guard);
 }
 
 /* Transitions a blocked thread T to the ready-to-run state.
@@ -318,21 +653,81 @@ thread_block (void) {
    This function does not preempt the running thread.  This can
    be important: if the caller had disabled interrupts itself,
    it may expect that it can atomically unblock a thread and
-   update other data. */
+   update other data.  If T goes into another CPU's run queue and
+   should preempt the thread running there, that CPU is sent a
+   reschedule interrupt.
+
+   Under the MLFQS this takes synch_lock, to bring T's priority up
+   to date, unless the caller already holds it. */
 
 // block된 쓰레드를 레디 상태로 바꾸고, 레디 큐에 넣어주는 함수
 void
 thread_unblock (struct thread *t) {
 	enum intr_level old_level;
+	bool synch_locked = false;
+	bool resched;
+	struct cpu *c;
 
 	ASSERT (is_thread (t));
 
 	old_level = intr_disable ();
+	if (thread_mlfqs && !spin_held_by_current_cpu (&synch_lock)) {
+		spin_lock (&synch_lock);
+		synch_locked = true;
+	}
+	c = thread_rq_lock (t);
 	ASSERT (t->status == THREAD_BLOCKED);
-	// list_push_back (&ready_list, &t->elem);		// 해당 쓰레드의 엘레멘트를 넣어준다. -> 상태를 레디 상태로 바꾸고, 
-	list_insert_ordered(&ready_list, &t->elem, cmp_thread_priority, NULL); // 수정 내림차순
+	if (thread_mlfqs)
+		set_priority_locked (c, t, mlfqs_priority (t));
+	if (t->edf)
+		edf_wakeup (t);
+	// 마지막으로 돌던 CPU의 우선순위 큐 맨 뒤에 넣어준다. (새 스레드는 현재 CPU)
+	ready_queue_push (c, t);
 	t->status = THREAD_READY;		// ready 상태로 만들어 주고
-	intr_set_level (old_level);					
+	t->ready_tsc = rdtsc ();
+	sched_trace (t, THREAD_BLOCKED, THREAD_READY, ST_UNBLOCK);
+	resched = c != cpu_current () && thread_preempts (c, t);
+	spin_unlock (&c->rq_lock);
+	if (synch_locked)
+		spin_unlock (&synch_lock);
+
+	if (resched)
+		cpu_resched (c);
+	else if (cpu_cnt > 1 && !cpu_current ()->wake_batch)
+		cpu_kick_idle ();		// 놀고 있는 CPU가 가져가도록 깨운다.
+	intr_set_level (old_level);
+}
+
+/* Acquires the run queue lock of the CPU that thread T is queued
+   on or last ran on, or the current CPU's for a thread that has
+   never run, and returns that CPU.  T may move to another CPU
+   until the lock is held, so this retries until it has the
+   right one.  Interrupts must be off. */
+static struct cpu *
+thread_rq_lock (struct thread *t) {
+	for (;;) {
+		struct cpu *c = t->cpu != NULL ? t->cpu : cpu_current ();
+
+		spin_lock (&c->rq_lock);
+		if (t->cpu == c || t->cpu == NULL)
+			return c;
+		spin_unlock (&c->rq_lock);
+	}
+}
+
+/* Returns true if ready thread T should preempt the thread that
+   CPU C is running.  C's run queue lock must be held. */
+static bool
+thread_preempts (struct cpu *c, struct thread *t) {
+	struct thread *curr = c->curr;
+
+	ASSERT (spin_held_by_current_cpu (&c->rq_lock));
+
+	if (curr == c->idle_thread)
+		return true;
+	if (t->edf)
+		return !curr->edf || t->edf_deadline < curr->edf_deadline;
+	return !curr->edf && t->priority > curr->priority;
 }
 
 // 수정!!
@@ -391,6 +786,11 @@ thread_exit (void) {
 	// 외부인터럽트가 아닐때,
 	ASSERT (!intr_context ());
 
+	if (thread_stats_on_exit)
+		print_thread_stats (thread_current ());
+	if (thread_current ()->edf)
+		thread_clear_edf ();
+
 #ifdef USERPROG
 	process_exit ();
 #endif
@@ -398,6 +798,7 @@ thread_exit (void) {
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();	// 비활성화
+	spin_lock (&cpu_current ()->rq_lock);
 	do_schedule (THREAD_DYING);	// 
 	NOT_REACHED ();
 }
@@ -410,6 +811,7 @@ void
 thread_yield (void) {
 	struct thread *curr = thread_current ();
 	enum intr_level old_level;
+	struct cpu *c;
 
 	// 외부 인터럽트 상태가 처리중에는 True를 반환하고, 그외의 모든 시간에는 False를 반환한다. 왜?)  
 	// 처리중이 아닐때만 넘어간다.
@@ -417,72 +819,410 @@ thread_yield (void) {
 
 	// 인터럽트 비활성화 시킴, old_level은 이전 상태를 받아옴, 
 	old_level = intr_disable ();
+
+	/* An EDF thread that has spent its budget sits out the rest
+	   of its period. */
+	if (curr->edf_throttled) {
+		curr->edf_throttled = false;
+		edf_next_period (curr);
+		intr_set_level (old_level);
+		return;
+	}
+
 	// 현재 쓰레드가 idle 쓰레드가 아니면 레디 중인 쓰레드가 없다.
-	if (curr != idle_thread)
-		// list_push_back (&ready_list, &curr->elem); // 레디 큐에 넣는다.
-		list_insert_ordered(&ready_list, &curr->elem, cmp_thread_priority, NULL);
+	c = cpu_current ();
+	spin_lock (&c->rq_lock);
+	if (curr != c->idle_thread) {
+		ready_queue_push (c, curr); // 레디 큐에 넣는다.
+		curr->ready_tsc = rdtsc ();
+	}
 	do_schedule (THREAD_READY);		// do_schedule() 현재 작동중인 쓰레드를 죽이지않고, 레디큐에 넣어주기 위해서 (양보당하는 애가 레디상태가 되고, 두 스케줄함수가 현재 러닝중인쓰레드를 인자로 넣어주는 상태로 바꿔주고, 등등) 
 	intr_set_level (old_level);
 }
 
+/* Earliest-deadline-first scheduling.
+
+   A thread in the EDF class has a reservation of RUNTIME ticks
+   of CPU time in every PERIOD ticks, to be used by DEADLINE
+   ticks into the period.  EDF threads run before all other
+   threads, whatever their priority, and among themselves the
+   one with the earliest deadline runs first.  As long as the
+   reservations on a CPU add up to no more than the whole CPU,
+   EDF meets every deadline, so thread_set_edf() turns down any
+   reservation that would take a CPU past EDF_UTIL_MAX.
+
+   A periodic thread calls thread_edf_yield() when it has done
+   the work of one period, and sleeps until the next.  A thread
+   that runs out of budget first is throttled by thread_tick()
+   and also waits for the next period, so that an overrunning
+   thread cannot eat into the other reservations or starve the
+   rest of the system.  A thread that blocks in the middle of a
+   period is held to its reservation when it wakes up by
+   edf_wakeup().
+
+   A reservation is admitted on the CPU that the thread is
+   running on, and the thread is pinned there until it leaves
+   the EDF class: EDF threads are never stolen by other CPUs, and
+   thread_unblock() always queues a thread on the CPU it last ran
+   on.  So each CPU's reservations stay within its own capacity. */
+
+/* Moves the running thread into the EDF class, with a
+   reservation of RUNTIME ticks in every PERIOD ticks, to be used
+   within DEADLINE ticks of the start of each period.  Its first
+   period starts now.  Returns false, leaving the thread as it
+   was, if the parameters are invalid or the reservation does not
+   fit on this CPU. */
+bool
+thread_set_edf (int64_t runtime, int64_t period, int64_t deadline) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	struct cpu *c;
+	long util;
+	bool success = false;
+
+	if (runtime <= 0 || runtime > deadline || deadline > period)
+		return false;
+	util = runtime * 1000000 / period;
+
+	old_level = intr_disable ();
+	c = cpu_current ();
+	spin_lock (&c->rq_lock);
+	if (curr->edf)
+		c->edf_util -= curr->edf_runtime * 1000000 / curr->edf_period;
+	if (c->edf_util + util <= EDF_UTIL_MAX) {
+		c->edf_util += util;
+		curr->edf = true;
+		curr->edf_runtime = runtime;
+		curr->edf_period = period;
+		curr->edf_rel_deadline = deadline;
+		curr->edf_period_start = timer_ticks ();
+		curr->edf_deadline = curr->edf_period_start + deadline;
+		curr->edf_budget = runtime;
+		success = true;
+	} else if (curr->edf)
+		c->edf_util += curr->edf_runtime * 1000000 / curr->edf_period;
+	spin_unlock (&c->rq_lock);
+	intr_set_level (old_level);
+	return success;
+}
+
+/* Moves the running thread out of the EDF class, back to
+   ordinary priority scheduling, and releases its reservation. */
 void
-thread_sleep (int64_t wake_ticks) {
+thread_clear_edf (void) {
 	struct thread *curr = thread_current ();
 	enum intr_level old_level;
+	struct cpu *c;
 
-	// 외부 인터럽트 상태가 처리중에는 True를 반환하고, 그외의 모든 시간에는 False를 반환한다. 왜?)  
-	// 처리중이 아닐때만 넘어간다.
+	old_level = intr_disable ();
+	c = cpu_current ();
+	spin_lock (&c->rq_lock);
+	if (curr->edf) {
+		c->edf_util -= curr->edf_runtime * 1000000 / curr->edf_period;
+		curr->edf = false;
+		curr->edf_throttled = false;
+	}
+	spin_unlock (&c->rq_lock);
+	intr_set_level (old_level);
+	preempt_priority ();
+}
+
+/* Ends the running EDF thread's work for this period, counting
+   a deadline miss if it is late, and sleeps until its next
+   period starts. */
+void
+thread_edf_yield (void) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (curr->edf);
+
+	old_level = intr_disable ();
+	curr->edf_jobs++;
+	if (timer_ticks () > curr->edf_deadline)
+		curr->edf_misses++;
+	curr->edf_throttled = false;
+	edf_next_period (curr);
+	intr_set_level (old_level);
+}
+
+/* Stores the number of periods' work that the running thread
+   has finished with thread_edf_yield() in *JOBS, and the number
+   of those that missed their deadline in *MISSES. */
+void
+thread_get_edf_stats (int64_t *jobs, int64_t *misses) {
+	struct thread *curr = thread_current ();
+
+	*jobs = curr->edf_jobs;
+	*misses = curr->edf_misses;
+}
+
+/* Starts the next period of EDF thread T, which must be the
+   running thread, with a full budget, and switches away until
+   the period starts.  A thread that is more than a period
+   behind starts its next period at once.  Interrupts must be
+   off. */
+static void
+edf_next_period (struct thread *t) {
+	struct cpu *c = cpu_current ();
+	int64_t now = timer_ticks ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t == thread_current ());
+
+	t->edf_period_start += t->edf_period;
+	if (t->edf_period_start < now)
+		t->edf_period_start = now;
+	t->edf_deadline = t->edf_period_start + t->edf_rel_deadline;
+	t->edf_budget = t->edf_runtime;
+
+	if (t->edf_period_start > now) {
+		t->sleep_deadline = t->edf_period_start;
+		spin_lock (&sleep_lock);
+		wheel_insert (&sleep_wheel, &t->sleep_elem, t->edf_period_start);
+		spin_lock (&c->rq_lock);
+		spin_unlock (&sleep_lock);
+		do_schedule (THREAD_BLOCKED);
+	} else {
+		spin_lock (&c->rq_lock);
+		ready_queue_push (c, t);
+		t->ready_tsc = rdtsc ();
+		do_schedule (THREAD_READY);
+	}
+}
+
+/* Applies the wakeup rule of the constant bandwidth server to
+   EDF thread T, which is waking up.  If using the budget it has
+   left between now and its deadline would take more than its
+   reserved share of the CPU, it starts a new period at once,
+   with a full budget and a later deadline.  Otherwise a thread
+   that slept through most of a period could spend its whole
+   budget just before the deadline, at the expense of the other
+   reservations.  T's run queue lock must be held. */
+static void
+edf_wakeup (struct thread *t) {
+	int64_t now = timer_ticks ();
+
+	ASSERT (spin_held_by_current_cpu (&t->cpu->rq_lock));
+
+	if (t->edf_budget * t->edf_period
+			> (t->edf_deadline - now) * t->edf_runtime) {
+		t->edf_period_start = now;
+		t->edf_deadline = now + t->edf_rel_deadline;
+		t->edf_budget = t->edf_runtime;
+	}
+}
+
+/* heap_less_func for EDF run queues: true if thread A's
+   deadline is later than B's, so that the earliest deadline is
+   the greatest element. */
+bool
+thread_deadline_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct thread, edf_elem)->edf_deadline
+		> heap_entry (b, struct thread, edf_elem)->edf_deadline;
+}
+
+/* Puts the current thread to sleep until the timer reaches tick
+   WAKE_TICK.  The thread is parked in a timing wheel, so this is
+   O(1) regardless of how many other threads are sleeping. */
+void
+thread_sleep (int64_t wake_tick) {
+	thread_sleep_range (wake_tick, wake_tick);
+}
+
+/* Puts the current thread to sleep until some tick between
+   EARLIEST and LATEST, inclusive.  The thread wakes at LATEST
+   unless some other sleeper must wake in the meantime, in which
+   case it goes along with that one. */
+void
+thread_sleep_range (int64_t earliest, int64_t latest) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	// 외부 인터럽트 처리중이 아닐때만 넘어간다.
 	ASSERT (!intr_context ());
+	ASSERT (curr != cpu_current ()->idle_thread);
+	ASSERT (earliest <= latest);
 
-	// 인터럽트 비활성화 시킴, old_level은 이전 상태를 받아옴, 
+	/* Hold sleep_lock until the run queue lock is held, so that
+	   thread_wake() cannot find this thread before it is blocked. */
 	old_level = intr_disable ();
-	// 현재 쓰레드가 idle 쓰레드가 아니면 레디 중인 쓰레드가 없다.
-	if (curr != idle_thread)
-		curr->wake_tick = wake_ticks;
-		list_insert_ordered (&sleep_list, &curr->elem, cmp, NULL);
-		// list_push_back (&ready_list, &curr->elem); // 레디 큐에 넣는다.
-	do_schedule (THREAD_BLOCKED);		// do_schedule() 현재 작동중인 쓰레드를 죽이지않고, 레디큐에 넣어주기 위해서 (양보당하는 애가 레디상태가 되고, 두 스케줄함수가 현재 러닝중인쓰레드를 인자로 넣어주는 상태로 바꿔주고, 등등) 
+	curr->sleep_deadline = latest;
+	curr->sleep_slack = false;
+	spin_lock (&sleep_lock);
+	wheel_insert (&sleep_wheel, &curr->sleep_elem, earliest);
+	spin_lock (&cpu_current ()->rq_lock);
+	spin_unlock (&sleep_lock);
+	do_schedule (THREAD_BLOCKED);
 	intr_set_level (old_level);
 }
 
-bool cmp(struct list_elem *state_a, struct list_elem *state_b, void *aux UNUSED)
-{
-	const struct thread *a = list_entry(state_a, struct thread, elem); // 리스트
-	const struct thread *b = list_entry(state_b, struct thread, elem);
-	return (a->wake_tick < b->wake_tick);
+/* Wakes up every sleeping thread whose deadline is at or before
+   TICK and, if there are any, every thread whose earliest wake
+   tick is, too.  Called by the timer interrupt handler, so the
+   preemption check, and the kick to an idle CPU, are made once
+   for the whole batch. */
+void
+thread_wake (int64_t tick) {
+	struct cpu *c = cpu_current ();
+	struct wake_pass pass = {tick, 0};
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&sleep_lock);
+	c->wake_batch = true;
+	wheel_advance (&sleep_wheel, tick, wake_sleeper, &pass);
+	if (pass.woken_cnt > 0) {
+		wake_pass_cnt++;
+		while (!list_empty (&slack_sleepers)) {
+			struct thread *t = list_entry (list_pop_front (&slack_sleepers),
+					struct thread, elem);
+
+			t->sleep_slack = false;
+			wheel_remove (&sleep_wheel, &t->sleep_elem);
+			sched_trace (t, THREAD_BLOCKED, THREAD_BLOCKED, ST_WAKE);
+			thread_unblock (t);
+		}
+	}
+	c->wake_batch = false;
+	spin_unlock (&sleep_lock);
+
+	if (pass.woken_cnt > 0) {
+		if (cpu_cnt > 1)
+			cpu_kick_idle ();
+		preempt_priority ();
+	}
 }
 
-void thread_wake(int64_t tick)
-{
-	// 앞에 뺸
-	while(!list_empty(&sleep_list) && list_entry(list_front(&sleep_list),struct thread ,elem)->wake_tick <= tick)
-	{
-		struct list_elem *front_elem = list_pop_front(&sleep_list);
-		thread_unblock(list_entry(front_elem, struct thread, elem));
+/* wheel_action_func for sleep_wheel, given the wake_pass that
+   PASS_ points to.  If the thread that owns sleep element E has
+   reached its deadline, unblocks it.  Otherwise it has only
+   reached its earliest wake tick, so it is moved onto
+   slack_sleepers and left in the wheel until its deadline. */
+static void
+wake_sleeper (struct wheel_elem *e, void *pass_) {
+	struct thread *t = wheel_entry (e, struct thread, sleep_elem);
+	struct wake_pass *pass = pass_;
+
+	if (pass->tick < t->sleep_deadline) {
+		t->sleep_slack = true;
+		list_push_back (&slack_sleepers, &t->elem);
+		wheel_insert (&sleep_wheel, e, t->sleep_deadline);
+		return;
+	}
 
-		// !수정!
-		preempt_priority();
+	if (t->sleep_slack) {
+		t->sleep_slack = false;
+		list_remove (&t->elem);
 	}
+	sched_trace (t, THREAD_BLOCKED, THREAD_BLOCKED, ST_WAKE);
+	thread_unblock (t);
+	pass->woken_cnt++;
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Sets the current thread's priority to NEW_PRIORITY.  Ignored
+   under the MLFQS, which sets priorities itself. */
 void
 thread_set_priority (int new_priority) {
+	enum intr_level old_level;
+
+	if (thread_mlfqs)
+		return;
+	old_level = synch_enter ();
 	thread_current ()->init_priority = new_priority; // main_thread->priority가 Default에서 33으로 변경
 	update_priority_for_donations();
+	synch_exit (old_level);
 	preempt_priority();
 }
 
-void preempt_priority(void)
-{
-    if (thread_current() == idle_thread)
-        return;
-    if (list_empty(&ready_list))
-        return;
-    struct thread *curr = thread_current();
-    struct thread *ready = list_entry(list_front(&ready_list), struct thread, elem);
-    if (curr->priority < ready->priority) // ready_list에 현재 실행중인 스레드보다 우선순위가 높은 스레드가 있으면
-        thread_yield();
+/* Sets T's effective priority to PRIORITY.  If T is waiting in
+   the run queue, it is moved to the tail of the queue for its
+   new priority, so that donation to a preempted lock holder
+   takes effect immediately.  If T is in a wait queue, it is
+   moved to its new place there, too.  If T now belongs ahead of
+   the thread running on another CPU, that CPU is sent a
+   reschedule interrupt.  synch_lock must be held. */
+void
+thread_set_effective_priority (struct thread *t, int priority) {
+	struct cpu *c;
+	bool resched;
+
+	ASSERT (is_thread (t));
+	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+	ASSERT (spin_held_by_current_cpu (&synch_lock));
+
+	c = thread_rq_lock (t);
+	resched = set_priority_locked (c, t, priority) && c != cpu_current ();
+	spin_unlock (&c->rq_lock);
+
+	if (t->waitq != NULL)
+		waitq_update (t);
+	if (resched)
+		cpu_resched (c);
+}
+
+/* Sets T's effective priority to PRIORITY, with the run queue
+   lock of C, T's CPU, held.  Returns true if T is ready and should
+   now preempt C's running thread. */
+static bool
+set_priority_locked (struct cpu *c, struct thread *t, int priority) {
+	ASSERT (spin_held_by_current_cpu (&c->rq_lock));
+
+	if (t->priority == priority)
+		return false;
+	if (t->status != THREAD_READY) {
+		t->priority = priority;
+		sched_trace (t, t->status, t->status, ST_PRIORITY);
+		return false;
+	}
+	ready_queue_remove (t);
+	t->priority = priority;
+	ready_queue_push (c, t);
+	sched_trace (t, t->status, t->status, ST_PRIORITY);
+	return thread_preempts (c, t);
+}
+
+/* Yields the CPU if a thread of higher priority than the
+   running thread is in this CPU's run queue.  Within an external
+   interrupt handler the yield is deferred until the interrupt
+   returns.  Threads made ready on other CPUs are looked after by
+   those CPUs, which thread_unblock() interrupts if need be.  Must
+   not be called with any spin lock held. */
+void
+preempt_priority (void) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	bool yield = false;
+	struct cpu *c;
+
+	old_level = intr_disable ();
+	c = cpu_current ();
+	if (curr == c->idle_thread) {
+		intr_set_level (old_level);
+		return;
+	}
+
+	spin_lock (&c->rq_lock);
+	if (!heap_empty (&c->edf_ready)) {
+		/* EDF threads run before all others, earliest deadline
+		   first. */
+		struct thread *t = heap_entry (heap_max (&c->edf_ready),
+				struct thread, edf_elem);
+
+		yield = !curr->edf || t->edf_deadline < curr->edf_deadline;
+	} else if (!curr->edf && c->ready_bitmap != 0)
+		// 레디 큐에 현재 실행중인 스레드보다 우선순위가 높은 스레드가 있으면
+		yield = curr->priority < highest_bit (c->ready_bitmap);
+	spin_unlock (&c->rq_lock);
+	intr_set_level (old_level);
+
+	if (yield) {
+		if (intr_context ())
+			intr_yield_on_return ();
+		else
+			thread_yield ();
+	}
 }
 
 /* Returns the current thread's priority. */
@@ -491,31 +1231,286 @@ thread_get_priority (void) {
 	return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE, which is
+   clamped to NICE_MIN...NICE_MAX, and recomputes its priority. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_nice (int nice) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	if (nice < NICE_MIN)
+		nice = NICE_MIN;
+	if (nice > NICE_MAX)
+		nice = NICE_MAX;
+
+	old_level = synch_enter ();
+	mlfqs_catch_up (curr);
+	curr->nice = nice;
+	if (thread_mlfqs)
+		mlfqs_refresh (curr);
+	synch_exit (old_level);
+	preempt_priority ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = synch_enter ();
+	int load = fp_round (fp_mul_int (load_avg, 100));
+
+	synch_exit (old_level);
+	return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	struct thread *curr = thread_current ();
+	enum intr_level old_level = synch_enter ();
+	int recent_cpu;
+
+	mlfqs_catch_up (curr);
+	recent_cpu = fp_round (fp_mul_int (curr->recent_cpu, 100));
+	synch_exit (old_level);
+	return recent_cpu;
+}
+
+/* Multi-level feedback queue scheduling.
+
+   Each thread's priority is PRI_MAX - recent_cpu / 4 - nice * 2,
+   where recent_cpu grows by one for every tick the thread runs,
+   and once a second decays for every thread by the factor
+   (2 * load_avg) / (2 * load_avg + 1), then has nice added.
+
+   Recomputing that for every thread inside the timer interrupt,
+   as the textbook does, makes the interrupt O(n) in the number
+   of threads.  Instead, the timer interrupt touches only the
+   running thread and, once a second, the load average, and every
+   other thread applies the decays it missed the next time it is
+   touched: when it is woken, when it asks for its recent_cpu, or
+   when it changes its nice.  Blocked threads, usually most of
+   them, cost nothing until they wake.  Ready threads must not
+   wait with a stale priority, so they are caught up each second
+   by mlfqs_refresh_ready(), in a worker thread rather than in
+   the interrupt, and a few at a time, so that interrupts are
+   never off for long however many threads are ready.
+
+   recent_cpu, nice, load_avg and the decay history are protected
+   by synch_lock, since a thread's MLFQS priority is combined with
+   the priority donated to it, which synch_lock also protects. */
+
+/* Called from thread_tick() for the running thread T on CPU C. */
+static void
+mlfqs_tick (struct thread *t, struct cpu *c) {
+	bool idle = t == c->idle_thread;
+
+	if (!idle) {
+		spin_lock (&synch_lock);
+		mlfqs_catch_up (t);
+		t->recent_cpu = fp_add_int (t->recent_cpu, 1);
+		spin_unlock (&synch_lock);
+	}
+
+	/* The load average is global, so only the CPU that counts
+	   timer ticks updates it. */
+	if (c->id == 0 && timer_ticks () % TIMER_FREQ == 0)
+		mlfqs_second ();
+
+	/* Only the running thread's recent_cpu changed, so only its
+	   priority needs recomputing, every fourth tick of its own
+	   CPU.  timer_ticks() only advances on the BSP. */
+	if (!idle && c->ticks % 4 == 0) {
+		spin_lock (&synch_lock);
+		mlfqs_refresh (t);
+		spin_unlock (&synch_lock);
+		preempt_priority ();
+	}
+}
+
+/* Updates the load average and starts the next decay of
+   recent_cpu.  Called once a second, in the timer interrupt. */
+static void
+mlfqs_second (void) {
+	int ready_cnt = 0;
+	int i;
+
+	/* Each run queue lock in turn, so the count is not a snapshot
+	   of all CPUs at once, but each CPU's part is consistent. */
+	for (i = 0; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[i];
+
+		spin_lock (&c->rq_lock);
+		ready_cnt += c->ready_cnt;
+		if (c->curr != c->idle_thread)
+			ready_cnt++;
+		spin_unlock (&c->rq_lock);
+	}
+
+	/* load_avg = (59/60) * load_avg + (1/60) * ready_cnt. */
+	spin_lock (&synch_lock);
+	load_avg = fp_div_int (fp_mul_int (load_avg, 59) + fp_from_int (ready_cnt),
+			60);
+	load_history[mlfqs_seconds % MLFQS_HISTORY] = load_avg;
+	mlfqs_seconds++;
+	spin_unlock (&synch_lock);
+	queue_work (&mlfqs_work);
+}
+
+/* Returns RECENT_CPU after N decays at load average LOAD for a
+   thread with niceness NICE.  One decay is
+   recent_cpu = a * recent_cpu + nice, with
+   a = (2 * load) / (2 * load + 1), so N of them come to
+   a^N * recent_cpu + nice * (1 - a^N) / (1 - a), where
+   1 / (1 - a) = 2 * load + 1. */
+static fixed_t
+mlfqs_decay (fixed_t recent_cpu, fixed_t load, int nice, int64_t n) {
+	fixed_t twice_load = fp_mul_int (load, 2);
+	fixed_t a = fp_div (twice_load, twice_load + FP_ONE);
+	fixed_t a_n = FP_ONE;
+
+	if (n == 1)
+		return fp_add_int (fp_mul (a, recent_cpu), nice);
+
+	/* a_n = a^N, by repeated squaring. */
+	for (; n > 0 && a != 0; n >>= 1) {
+		if (n & 1)
+			a_n = fp_mul (a_n, a);
+		a = fp_mul (a, a);
+	}
+	if (n > 0)
+		a_n = 0;
+	return fp_mul (a_n, recent_cpu)
+		+ fp_mul_int (fp_mul (FP_ONE - a_n, twice_load + FP_ONE), nice);
+}
+
+/* Applies to T's recent_cpu the decays that have happened since
+   it was last brought up to date.  Decays older than the history
+   kept in load_history are applied all at once at the oldest
+   load average still known, which is close enough: by then the
+   old recent_cpu has mostly decayed away.  So this costs at most
+   MLFQS_HISTORY steps however long T slept.  synch_lock must be
+   held. */
+static void
+mlfqs_catch_up (struct thread *t) {
+	int64_t oldest = mlfqs_seconds - MLFQS_HISTORY;
+
+	ASSERT (spin_held_by_current_cpu (&synch_lock));
+
+	if (t->mlfqs_stamp < oldest) {
+		t->recent_cpu = mlfqs_decay (t->recent_cpu,
+				load_history[oldest % MLFQS_HISTORY], t->nice,
+				oldest - t->mlfqs_stamp);
+		t->mlfqs_stamp = oldest;
+	}
+	for (; t->mlfqs_stamp < mlfqs_seconds; t->mlfqs_stamp++)
+		t->recent_cpu = mlfqs_decay (t->recent_cpu,
+				load_history[t->mlfqs_stamp % MLFQS_HISTORY], t->nice, 1);
+}
+
+/* Brings T's recent_cpu up to date, recomputes its MLFQS
+   priority from it, and returns the effective priority that T
+   should have.  The MLFQS priority takes the place of the
+   priority that T would otherwise have set itself, so donations
+   still raise it above that.  A thread created at PRI_MAX stays
+   there.  synch_lock must be held. */
+static int
+mlfqs_priority (struct thread *t) {
+	int priority, donated;
+
+	mlfqs_catch_up (t);
+	if (t->mlfqs_fixed)
+		return PRI_MAX;
+	priority = PRI_MAX - fp_to_int (fp_div_int (t->recent_cpu, 4)) - t->nice * 2;
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	t->init_priority = priority;
+
+	donated = lock_donated_priority (t);
+	return priority > donated ? priority : donated;
+}
+
+/* Brings T's MLFQS priority up to date.  synch_lock must be
+   held. */
+static void
+mlfqs_refresh (struct thread *t) {
+	thread_set_effective_priority (t, mlfqs_priority (t));
+}
+
+/* Work function that refreshes the priority of every thread in
+   every CPU's run queue after a decay, MLFQS_REFRESH_BATCH threads
+   at a time, with interrupts back on in between.  EDF threads run
+   ahead of all of these anyway and are refreshed when they next
+   wake. */
+static void
+mlfqs_refresh_ready (void *aux UNUSED) {
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[i];
+		bool more;
+
+		do {
+			enum intr_level old_level = synch_enter ();
+			bool resched = false;
+
+			spin_lock (&c->rq_lock);
+			more = mlfqs_refresh_batch (c, &resched);
+			spin_unlock (&c->rq_lock);
+			if (resched && c != cpu_current ())
+				cpu_resched (c);
+			synch_exit (old_level);
+			preempt_priority ();
+		} while (more);
+	}
+}
+
+/* Refreshes up to MLFQS_REFRESH_BATCH threads in C's run queue
+   that missed a decay.  Each refreshed thread goes to the tail of
+   the queue for its new priority, which keeps the order of the
+   threads within each queue and leaves the ones still to do at
+   the heads of the queues, so each batch starts where the last
+   one stopped.  (A stale thread put behind fresh ones in the
+   meantime, e.g. by a donation, waits for the next decay's pass.)
+   Sets *RESCHED if a refreshed thread should preempt C's running
+   thread.  Returns true if there may be more to do.  synch_lock
+   and C's run queue lock must be held. */
+static bool
+mlfqs_refresh_batch (struct cpu *c, bool *resched) {
+	int budget = MLFQS_REFRESH_BATCH;
+	int pri;
+
+	for (pri = PRI_MAX; pri >= PRI_MIN; pri--) {
+		struct list *q = &c->ready_queues[pri];
+
+		while (!list_empty (q)) {
+			struct thread *t = list_entry (list_front (q), struct thread, elem);
+			int priority;
+
+			if (t->mlfqs_stamp == mlfqs_seconds)
+				break;
+			if (budget-- == 0)
+				return true;
+
+			priority = mlfqs_priority (t);
+			ready_queue_remove (t);
+			if (t->priority != priority) {
+				t->priority = priority;
+				sched_trace (t, t->status, t->status, ST_PRIORITY);
+			}
+			ready_queue_push (c, t);
+			if (thread_preempts (c, t))
+				*resched = true;
+		}
+	}
+	return false;
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -538,11 +1533,13 @@ static void
 idle (void *idle_started_ UNUSED) {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current (); // 현재 실행 중인 쓰레드를 가리키는 포인터 (실제 쓰레드인지 확인)
+	cpu_current ()->idle_thread = thread_current (); // 현재 실행 중인 쓰레드를 가리키는 포인터 (실제 쓰레드인지 확인)
 
 	// 이 함수는 스레드 간의 대기(wait)와 신호(signal)을 이용하여 스레드의 실행을 동기화하는데 사용되며,
 	// 세마포어의 값을 증가시킴으로써 대기 중인 스레드 중 하나를 깨워서 실행 가능한 상태로 만들 수 있습니다.
-	sema_up (idle_started);
+	// (AP의 idle 스레드는 기다리는 사람이 없다.)
+	if (idle_started != NULL)
+		sema_up (idle_started);
 
 	for (;;) {
 		/* Let someone else run. - 다른 누군가에게 실행을 맡깁니다 */
@@ -550,19 +1547,28 @@ idle (void *idle_started_ UNUSED) {
 		thread_block (); 	// 현재 스레드를 block 시킵니다. 
 							// 이 작업은 아이들 스레드를 대기 상태로 만들고 다른 스레드가 실행될 수 있도록 합니다.
 
-		/* Re-enable interrupts and wait for the next one.
+		/* Spend idle time zeroing a page for palloc's reserve, if
+		   it wants one, then look for work again. */
+		if (palloc_zero_idle ())
+			continue;
+
+		/* Nothing is ready to run.  In tickless mode, stop the
+		   periodic tick until the earliest sleeper or delayed work
+		   is due; nothing else can need the CPU before some
+		   interrupt arrives. */
+		if (timer_nohz) {
+			int64_t wake_tick, work_tick;
 
-		   The `sti' instruction disables interrupts until the
-		   completion of the next instruction, so these two
-		   instructions are executed atomically.  This atomicity is
-		   important; otherwise, an interrupt could be handled
-		   between re-enabling interrupts and waiting for the next
-		   one to occur, wasting as much as one clock tick worth of
-		   time.
+			spin_lock (&sleep_lock);
+			wake_tick = wheel_next_expiry (&sleep_wheel);
+			spin_unlock (&sleep_lock);
+			work_tick = workqueue_next_expiry ();
+
+			timer_nohz_enter (work_tick < wake_tick ? work_tick : wake_tick);
+		}
 
-		   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-		   7.11.1 "HLT Instruction". */
-		asm volatile ("sti; hlt" : : : "memory"); // 인터럽트를 활성화 -> CPU를 대기 상태로 전환
+		/* Re-enable interrupts and wait for the next one. */
+		intr_wait (); // 인터럽트를 활성화 -> CPU를 대기 상태로 전환
 	}
 }
 
@@ -571,6 +1577,7 @@ static void
 kernel_thread (thread_func *function, void *aux) {
 	ASSERT (function != NULL);
 
+	schedule_tail ();     /* Finish the switch to this thread. */
 	intr_enable ();       /* The scheduler runs with interrupts off. */
 	function (aux);       /* Execute the thread function. */
 	thread_exit ();       /* If function() returns, kill the thread. */
@@ -605,15 +1612,69 @@ init_thread (struct thread *t, const char *name, int priority) {
 
 	t->init_priority = priority;
     t->wait_on_lock = NULL;
-    list_init(&(t->donations));
+    heap_init(&t->held_locks, lock_priority_less, NULL);
+	t->wait_on_rwlock = NULL;
+	t->acct_tsc = rdtsc ();
+    wheel_elem_init (&t->sleep_elem);
+
+}
+
+/* Returns a page for a new thread, or a null pointer if memory
+   is short.  Only the `struct thread' at the bottom of the page
+   needs to be cleared, which init_thread() does, so a page from
+   the thread cache is handed out as is. */
+static struct thread *
+thread_page_get (void) {
+	struct thread *t = NULL;
+	enum intr_level old_level;
+
+	if (thread_cache_disabled)
+		return palloc_get_page (PAL_ZERO);
+
+	old_level = intr_disable ();
+	spin_lock (&thread_cache_lock);
+	if (!list_empty (&thread_cache)) {
+		t = list_entry (list_pop_front (&thread_cache), struct thread, elem);
+		thread_cache_cnt--;
+	}
+	spin_unlock (&thread_cache_lock);
+	intr_set_level (old_level);
+
+	return t != NULL ? t : palloc_get_page (0);
+}
+
+/* Releases the page of dead thread T, keeping it in the thread
+   cache if there is room.  Interrupts must be off. */
+static void
+thread_page_put (struct thread *t) {
+	bool cached = false;
 
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&thread_cache_lock);
+	if (!thread_cache_disabled && thread_cache_cnt < THREAD_CACHE_MAX) {
+		list_push_front (&thread_cache, &t->elem);
+		thread_cache_cnt++;
+		cached = true;
+	}
+	spin_unlock (&thread_cache_lock);
+	if (!cached)
+		palloc_free_page (t);
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
-   will be in the run queue.)  If the run queue is empty, return
-   idle_thread.
+   will be in the run queue.)  If the run queue is empty, steal
+   the highest-priority thread queued on any other CPU, and if
+   there is none, return this CPU's idle thread.
+
+   This CPU's run queue lock is held.  Another CPU's is only
+   tried, not waited for, since two idle CPUs could otherwise
+   each wait for the other's; if it is busy, this CPU idles until
+   its next interrupt.  A thread that another CPU is still
+   switching away from cannot be stolen, since that CPU holds its
+   run queue lock until the switch is complete.
    
    다음 스레드를 선택하고 반환하는 함수입니다. 실행 대기열(run queue)에서 스레드를 반환해야 하며,
    실행 대기열이 비어있는 경우 idle_thread를 반환해야 합니다.
@@ -622,10 +1683,89 @@ init_thread (struct thread *t, const char *name, int priority) {
 
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
-		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	struct cpu *c = cpu_current ();
+	struct cpu *victim = NULL;
+	int victim_pri = -1;
+	struct thread *t;
+	int i;
+
+	ASSERT (spin_held_by_current_cpu (&c->rq_lock));
+
+	if (!heap_empty (&c->edf_ready)) {
+		c->ready_cnt--;
+		return heap_entry (heap_pop_max (&c->edf_ready), struct thread, edf_elem);
+	}
+	if (c->ready_bitmap != 0)
+		return ready_queue_pop (c);
+
+	/* Peek at the other run queues without their locks, then lock
+	   the best one and make sure it still has something. */
+	for (i = 0; i < cpu_cnt; i++) {
+		struct cpu *other = &cpus[i];
+		uint64_t bitmap = *(volatile uint64_t *) &other->ready_bitmap;
+
+		if (other != c && bitmap != 0 && highest_bit (bitmap) > victim_pri) {
+			victim = other;
+			victim_pri = highest_bit (bitmap);
+		}
+	}
+	if (victim == NULL || !spin_try_lock (&victim->rq_lock))
+		return c->idle_thread;
+	if (victim->ready_bitmap == 0) {
+		spin_unlock (&victim->rq_lock);
+		return c->idle_thread;
+	}
+
+	t = ready_queue_pop (victim);
+	t->cpu = c;
+	spin_unlock (&victim->rq_lock);
+	c->steal_cnt++;
+	return t;
+}
+
+/* Appends T to C's run queue for its priority, or adds it to
+   C's EDF run queue if it is in the EDF class. */
+static void
+ready_queue_push (struct cpu *c, struct thread *t) {
+	ASSERT (!t->edf || t->cpu == c);
+
+	t->cpu = c;
+	c->ready_cnt++;
+	if (t->edf) {
+		heap_insert (&c->edf_ready, &t->edf_elem);
+		return;
+	}
+	list_push_back (&c->ready_queues[t->priority], &t->elem);
+	c->ready_bitmap |= 1ULL << t->priority;
+}
+
+/* Removes T from the run queue it is in. */
+static void
+ready_queue_remove (struct thread *t) {
+	struct cpu *c = t->cpu;
+
+	c->ready_cnt--;
+	if (t->edf) {
+		heap_remove (&c->edf_ready, &t->edf_elem);
+		return;
+	}
+	list_remove (&t->elem);
+	if (list_empty (&c->ready_queues[t->priority]))
+		c->ready_bitmap &= ~(1ULL << t->priority);
+}
+
+/* Removes and returns the thread at the head of C's highest
+   nonempty run queue.  The run queue must not be empty. */
+static struct thread *
+ready_queue_pop (struct cpu *c) {
+	int pri = highest_bit (c->ready_bitmap);
+	struct thread *t =
+		list_entry (list_pop_front (&c->ready_queues[pri]), struct thread, elem);
+
+	if (list_empty (&c->ready_queues[pri]))
+		c->ready_bitmap &= ~(1ULL << pri);
+	c->ready_cnt--;
+	return t;
 }
 
 /* Use iretq to launch the thread */
@@ -670,10 +1810,46 @@ do_iret (struct intr_frame *tf) {
 // 컨텍스트 
 static void
 thread_launch (struct thread *th) {
-	uint64_t tf_cur = (uint64_t) &running_thread ()->tf;
-	uint64_t tf = (uint64_t) &th->tf;
+	struct thread *curr = running_thread ();
+
 	ASSERT (intr_get_level () == INTR_OFF);
 
+	/* Both threads are kernel threads inside schedule(), so
+	   normally saving the callee-saved registers and the stack
+	   pointer is enough.  Only a thread whose state is in its
+	   interrupt frame, because it has never run or was switched
+	   out by thread_launch_iret(), has to start through iretq. */
+	if (thread_switch_iret)
+		thread_launch_iret (curr, th);
+	else if (th->switch_rsp != 0)
+		switch_context (&curr->switch_rsp, th->switch_rsp);
+	else
+		switch_to_frame (&curr->switch_rsp, &th->tf);
+}
+
+/* Resumes TH, which thread_launch_iret() is switching to, in
+   whichever way it was switched out. */
+void
+thread_switch_resume (struct thread *th) {
+	static uint64_t discard;
+
+	if (th->switch_rsp != 0)
+		switch_context (&discard, th->switch_rsp);
+	else
+		do_iret (&th->tf);
+	NOT_REACHED ();
+}
+
+/* Switches from CURR to TH the way Pintos originally did: by
+   spilling every register of CURR into its interrupt frame, then
+   resuming TH.  Kept for comparison with switch_context(). */
+static void
+thread_launch_iret (struct thread *curr, struct thread *th) {
+	uint64_t tf_cur = (uint64_t) &curr->tf;
+
+	/* Resume CURR from its interrupt frame next time. */
+	curr->switch_rsp = 0;
+
 	/* The main switching logic.
 	 * We first restore the whole execution context into the intr_frame
 	 * and then switching to the next thread by calling do_iret.
@@ -721,13 +1897,14 @@ thread_launch (struct thread *th) {
 			"mov %%rsp, 24(%%rax)\n" // rsp
 			"movw %%ss, 32(%%rax)\n"
 			"mov %%rcx, %%rdi\n"
-			"call do_iret\n"
+			"call thread_switch_resume\n"
 			"out_iret:\n"
-			: : "g"(tf_cur), "g" (tf) : "memory"
+			: : "g"(tf_cur), "g" (th) : "memory"
 			);
 }
 
-/* Schedules a new process. At entry, interrupts must be off.
+/* Schedules a new process. At entry, interrupts must be off and
+ * the current CPU's run queue lock must be held.
  * This function modify current thread's status to status and then
  * finds another thread to run and switches to it.
  * It's not safe to call printf() in the schedule().
@@ -746,17 +1923,10 @@ do_schedule(int status) {
 
 	// 인터럽트가 꺼져있는 상태, 
 	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spin_held_by_current_cpu (&cpu_current ()->rq_lock));
 	// 쓰레드 상태가 러닝중일때,
 	ASSERT (thread_current()->status == THREAD_RUNNING);
 
-	while (!list_empty (&destruction_req)) { // 비어있지 않으면 -> 비어있으면 while 종료
-		// 더이상 파괴하려는 쓰레드가 없을 때까지 while문 실행 -> 
-		struct thread *victim =
-			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		
-		// 피지컬 페이지 -> 동적 할당 아닌 것 같음, 희생자들의 프리 시킴, FIFO, 
-		palloc_free_page(victim);
-	}
 	// 입맛대로 쓰면 된다.
 	thread_current ()->status = status;
 
@@ -767,23 +1937,40 @@ do_schedule(int status) {
 // 왜 호출 -> 블록 해줬으니까 다시 레디큐에 있는 러닝상태로 바꿔주기
 static void
 schedule (void) {
+	struct cpu *c = cpu_current ();
 	struct thread *curr = running_thread (); // 현재 실행 중인 스레드
-	struct thread *next = next_thread_to_run (); // 레디 큐에서 다음에 실행할 스레드 골라서 return, (현재 round-robin)
+	struct thread *next;
 
 	// 다른 쓰레드가 스케줄링 중일때는 인터럽트가 걸리면 안되니까 비활성화
 	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spin_held_by_current_cpu (&c->rq_lock));
 	
 	// 현재 쓰레드가 러닝 상태가 아니면 다음으로 넘어간다.  
 	ASSERT (curr->status != THREAD_RUNNING);
 
+	next = next_thread_to_run (); // 레디 큐에서 다음에 실행할 스레드 골라서 return, (현재 round-robin)
+
+	/* Let RCU know if CURR is leaving a read-side critical
+	   section behind. */
+	rcu_note_switch (curr);
+
 	// 쓰레드인지 확인, 레디, 블럭, 죽은 거 다 넘어옴
 	ASSERT (is_thread (next));
 
-	/* Mark us as running. */
+	if (curr != next) {
+		c->switch_cnt++;
+		acct_switch (curr, next);
+		sched_trace (curr, THREAD_RUNNING, curr->status, ST_SWITCH_OUT);
+		sched_trace (next, next->status, THREAD_RUNNING, ST_SWITCH_IN);
+	}
+
+	/* Mark us as running, on this CPU. */
 	next->status = THREAD_RUNNING;
+	next->cpu = c;
+	c->curr = next;
 
 	/* Start new time slice. 시간을 얼마냐 썼냐 -> 다음으로 넘어갔음 */
-	thread_ticks = 0;
+	c->thread_ticks = 0;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -794,15 +1981,14 @@ schedule (void) {
 		/* If the thread we switched from is dying, destroy its struct
 		   thread. This must happen late so that thread_exit() doesn't
 		   pull out the rug under itself.
-		   We just queuing the page free reqeust here because the page is
-		   currently used by the stack.
-		   The real destruction logic will be called at the beginning of the
-		   schedule(). */
+		   We just note the page here because the page is currently
+		   used by the stack.  The thread we switch to frees it in
+		   schedule_tail(). */
 
 		// 맨처음(메인) 쓰레드 이닛에서 호출할 떄 (맨 처음 생성된 쓰레드 initial_thread)가 아니여야 한다.
 		if (curr && curr->status == THREAD_DYING && curr != initial_thread) {
 			ASSERT (curr != next);
-			list_push_back (&destruction_req, &curr->elem);
+			c->dying = curr;
 		}
 
 		/* Before switching the thread, we first save the information
@@ -811,6 +1997,28 @@ schedule (void) {
 		// 
 		thread_launch (next);
 	}
+	schedule_tail ();
+}
+
+/* Completes a thread switch, in the thread switched to, which
+   is either back in schedule() or just starting in
+   kernel_thread().  Releases the run queue lock that schedule()
+   was called with, which may have been taken by a different
+   thread, then frees the thread switched away from if it died.
+   A thread switch is also a quiescent state for RCU.  Interrupts
+   must be off. */
+static void
+schedule_tail (void) {
+	struct cpu *c = cpu_current ();
+	struct thread *dying = c->dying;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	c->dying = NULL;
+	spin_unlock (&c->rq_lock);
+	if (dying != NULL)
+		thread_page_put (dying);
+	rcu_quiescent_state ();
 }
 
 /* Returns a tid to use for a new thread. - 새로운 스레드에 사용할 스레드 ID(tid)를 반환합니다. */
@@ -0,0 +1,279 @@
+#include "threads/vmalloc.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Virtually contiguous kernel memory.  See vmalloc.h.
+
+   A bitmap tracks which pages of the reserved range are taken.
+   Each block is followed by one page that is never mapped, so
+   that running off the end of a block faults instead of
+   corrupting its neighbor, and so that vfree() can find the end
+   of a block by walking its page table entries.  The page tables
+   for the range hang off base_pml4 and are never freed.
+
+   There is no way to make another CPU flush its TLB on demand,
+   so vfree() flushes only the CPU it runs on.  Another CPU may
+   still hold translations for the freed pages, which is harmless
+   as long as nothing maps different frames there.  So freed
+   pages stay marked in use, as "stale", until vmalloc() runs out
+   of space.  Then it bumps flush_gen, which every CPU catches up
+   with by reloading CR3 in vmalloc_tick(), and moves the stale
+   pages to purge_map.  They can be used again once every CPU has
+   caught up.  vmalloc() does not wait for that, since it would
+   take up to a tick; it fails instead, and a later call reuses
+   the pages.  This batches the flushes, as Linux does with its
+   lazily purged vmap areas. */
+
+/* Bitmaps of pages in the range.  used_map includes the stale
+   pages, which are in stale_map if they were freed since the
+   last bump of flush_gen, or in purge_map if before. */
+static struct bitmap *used_map;
+static struct bitmap *stale_map;
+static struct bitmap *purge_map;
+static size_t stale_cnt;
+static size_t purge_cnt;
+static uint8_t used_buf[VMALLOC_PAGES / 8 + 64];
+static uint8_t stale_buf[VMALLOC_PAGES / 8 + 64];
+static uint8_t purge_buf[VMALLOC_PAGES / 8 + 64];
+
+/* Protects the bitmaps and the page tables of the range. */
+static struct lock vmalloc_lock;
+
+/* Flush generation.  Each CPU's tlb_gen catches up with it in
+   vmalloc_tick(). */
+static volatile int64_t flush_gen;
+
+static size_t claim_pages (size_t page_cnt);
+static void unmap_pages (uint8_t *, size_t page_cnt);
+static bool purge_stale (void);
+
+/* Initializes the vmalloc() range.  Must be called after
+   paging_init(). */
+void
+vmalloc_init (void) {
+	ASSERT (base_pml4 != NULL);
+	ASSERT (PML4 (VMALLOC_START) == PML4 (KERN_BASE));
+	ASSERT (PML4 (VMALLOC_END - 1) == PML4 (KERN_BASE));
+
+	used_map = bitmap_create_in_buf (VMALLOC_PAGES, used_buf, sizeof used_buf);
+	stale_map = bitmap_create_in_buf (VMALLOC_PAGES, stale_buf,
+			sizeof stale_buf);
+	purge_map = bitmap_create_in_buf (VMALLOC_PAGES, purge_buf,
+			sizeof purge_buf);
+	lock_init (&vmalloc_lock);
+	lock_set_name (&vmalloc_lock, "vmalloc");
+}
+
+/* Allocates and returns a block of SIZE bytes, rounded up to
+   whole pages, that is contiguous in kernel virtual memory but
+   not necessarily in physical memory.  Returns a null pointer if
+   there is not enough memory or address space, or if called
+   before vmalloc_init().  Address space that is waiting for
+   other CPUs to flush their TLBs does not count, so a call that
+   fails may succeed a tick later.  May sleep. */
+void *
+vmalloc (size_t size) {
+	size_t page_cnt = DIV_ROUND_UP (size, PGSIZE);
+	size_t idx, i;
+	uint8_t *block;
+
+	if (page_cnt == 0 || used_map == NULL)
+		return NULL;
+
+	lock_acquire (&vmalloc_lock);
+	idx = claim_pages (page_cnt);
+	if (idx == BITMAP_ERROR) {
+		lock_release (&vmalloc_lock);
+		return NULL;
+	}
+
+	block = (uint8_t *) VMALLOC_START + idx * PGSIZE;
+	for (i = 0; i < page_cnt; i++) {
+		void *kpage = palloc_get_page (0);
+		uint64_t *pte;
+
+		if (kpage == NULL)
+			break;
+		pte = pml4e_walk (base_pml4, (uint64_t) (block + i * PGSIZE), 1);
+		if (pte == NULL) {
+			palloc_free_page (kpage);
+			break;
+		}
+		ASSERT ((*pte & PTE_P) == 0);
+		*pte = vtop (kpage) | PTE_P | PTE_W;
+	}
+	if (i < page_cnt) {
+		unmap_pages (block, i);
+		bitmap_set_multiple (stale_map, idx, page_cnt + 1, true);
+		stale_cnt += page_cnt + 1;
+		block = NULL;
+	}
+	lock_release (&vmalloc_lock);
+	return block;
+}
+
+/* Frees BLOCK, which must have been returned by vmalloc().  A
+   null BLOCK is ignored.  May sleep. */
+void
+vfree (void *block_) {
+	uint8_t *block = block_;
+	size_t idx, page_cnt;
+
+	if (block == NULL)
+		return;
+	ASSERT (is_vmalloc_vaddr (block));
+	ASSERT (pg_ofs (block) == 0);
+
+	lock_acquire (&vmalloc_lock);
+	idx = pg_no (block) - pg_no (VMALLOC_START);
+	page_cnt = 0;
+	while (idx + page_cnt < VMALLOC_PAGES) {
+		uint64_t *pte = pml4e_walk (base_pml4,
+				(uint64_t) (block + page_cnt * PGSIZE), 0);
+		if (pte == NULL || (*pte & PTE_P) == 0)
+			break;
+		page_cnt++;
+	}
+	ASSERT (page_cnt > 0);
+	ASSERT (bitmap_all (used_map, idx, page_cnt + 1));
+
+	unmap_pages (block, page_cnt);
+	bitmap_set_multiple (stale_map, idx, page_cnt + 1, true);
+	stale_cnt += page_cnt + 1;
+	lock_release (&vmalloc_lock);
+}
+
+/* Flushes this CPU's TLB if a purge is waiting for it.  Called
+   by the timer interrupt handler on every CPU. */
+void
+vmalloc_tick (void) {
+	struct cpu *c = cpu_current ();
+	int64_t gen = flush_gen;
+
+	if (c->tlb_gen != gen) {
+		lcr3 (rcr3 ());
+		c->tlb_gen = gen;
+	}
+}
+
+/* Allocates SIZE bytes for a large table, such as a hash
+   table's buckets: from vmalloc() if SIZE is more than a page,
+   so that it need not be physically contiguous, and otherwise,
+   or if vmalloc() fails, from malloc().  Returns a null pointer
+   if neither has the memory.  May sleep. */
+void *
+kvmalloc (size_t size) {
+	void *p = size > PGSIZE ? vmalloc (size) : NULL;
+
+	return p != NULL ? p : malloc (size);
+}
+
+/* Like kvmalloc(), for an array of A elements of B bytes each,
+   zeroed. */
+void *
+kvcalloc (size_t a, size_t b) {
+	size_t size = a * b;
+	void *p;
+
+	if (size < a || size < b)
+		return NULL;
+	p = kvmalloc (size);
+	if (p != NULL)
+		memset (p, 0, size);
+	return p;
+}
+
+/* Frees P, which must have been returned by kvmalloc() or
+   kvcalloc().  A null P is ignored.  May sleep. */
+void
+kvfree (void *p) {
+	if (is_vmalloc_vaddr (p))
+		vfree (p);
+	else
+		free (p);
+}
+
+/* Finds PAGE_CNT free pages plus a guard page in the range,
+   marks them used, and returns the index of the first, or
+   BITMAP_ERROR if there is no room even after purging what stale
+   pages can be.  vmalloc_lock must be held. */
+static size_t
+claim_pages (size_t page_cnt) {
+	size_t idx = bitmap_scan_and_flip (used_map, 0, page_cnt + 1, false);
+
+	if (idx == BITMAP_ERROR && purge_stale ())
+		idx = bitmap_scan_and_flip (used_map, 0, page_cnt + 1, false);
+	return idx;
+}
+
+/* Unmaps the PAGE_CNT pages starting at BLOCK and frees their
+   frames.  Only this CPU's TLB is flushed.  vmalloc_lock must be
+   held. */
+static void
+unmap_pages (uint8_t *block, size_t page_cnt) {
+	size_t i;
+
+	for (i = 0; i < page_cnt; i++) {
+		uint8_t *page = block + i * PGSIZE;
+		uint64_t *pte = pml4e_walk (base_pml4, (uint64_t) page, 0);
+
+		ASSERT (pte != NULL && (*pte & PTE_P) != 0);
+		palloc_free_page (ptov (PTE_ADDR (*pte)));
+		*pte = 0;
+		invlpg ((uint64_t) page);
+	}
+}
+
+/* Makes stale pages available again once no CPU can hold a
+   translation for them, without waiting for that.  Pages in
+   purge_map are freed if every CPU has flushed its TLB since
+   they were moved there.  Otherwise, if no pages are in
+   purge_map, the ones in stale_map are moved there and every CPU
+   is asked to flush on its next timer tick.  Returns true if
+   some pages were freed.  vmalloc_lock must be held. */
+static bool
+purge_stale (void) {
+	enum intr_level old_level;
+	struct bitmap *tmp;
+	size_t idx;
+	int i;
+
+	if (purge_cnt == 0) {
+		if (stale_cnt == 0)
+			return false;
+		tmp = purge_map;
+		purge_map = stale_map;
+		stale_map = tmp;
+		purge_cnt = stale_cnt;
+		stale_cnt = 0;
+
+		/* Flush here, and ask every other CPU to flush on its next
+		   timer tick. */
+		old_level = intr_disable ();
+		cpu_current ()->tlb_gen = ++flush_gen;
+		lcr3 (rcr3 ());
+		intr_set_level (old_level);
+	}
+
+	for (i = 0; i < cpu_cnt; i++)
+		if (cpus[i].tlb_gen < flush_gen)
+			return false;
+
+	for (idx = 0; (idx = bitmap_scan (purge_map, idx, 1, true)) != BITMAP_ERROR;
+			idx++)
+		bitmap_reset (used_map, idx);
+	bitmap_set_all (purge_map, false);
+	purge_cnt = 0;
+	return true;
+}
@@ -0,0 +1,186 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Deferred work.  See workqueue.h.
+
+   Queued work goes on a single FIFO list served by WORKER_CNT
+   kernel threads.  The workers run at PRI_MAX, so that work
+   queued by an interrupt handler runs as soon as the handler
+   returns, ahead of ordinary threads, much like a bottom half.
+   Delayed work waits in a timing wheel advanced by the timer
+   interrupt, then joins the list.
+
+   Everything here is protected by wq_lock, a spin lock, so
+   queue_work() and queue_delayed_work() may be called from
+   interrupt handlers.  Workers are woken only after it is
+   released, because waking a thread takes the scheduler's
+   locks. */
+
+/* Number of worker threads. */
+#define WORKER_CNT 2
+
+static struct list pending;     /* Queued work, oldest first. */
+static struct semaphore pending_cnt;    /* Counts entries in PENDING. */
+static struct wheel delayed;    /* Delayed work, by expiry tick. */
+static struct spinlock wq_lock;
+
+static thread_func worker_thread;
+static void expire_delayed (struct wheel_elem *, void *aux);
+static void enqueue (struct work *);
+
+/* Initializes the work queues.  Work may be queued from here on,
+   but does not run before workqueue_start(). */
+void
+workqueue_init (void) {
+	list_init (&pending);
+	sema_init (&pending_cnt, 0);
+	spin_init (&wq_lock);
+	wheel_init (&delayed, timer_ticks ());
+}
+
+/* Starts the worker threads. */
+void
+workqueue_start (void) {
+	int i;
+
+	for (i = 0; i < WORKER_CNT; i++) {
+		char name[16];
+
+		snprintf (name, sizeof name, "kworker%d", i);
+		if (thread_create (name, PRI_MAX, worker_thread, NULL) == TID_ERROR)
+			PANIC ("cannot start %s", name);
+	}
+}
+
+/* Initializes W to run FUNC, passing AUX, when it is queued. */
+void
+work_init (struct work *w, work_func *func, void *aux) {
+	ASSERT (w != NULL);
+	ASSERT (func != NULL);
+
+	wheel_elem_init (&w->timer);
+	w->func = func;
+	w->aux = aux;
+	w->pending = false;
+}
+
+/* Queues W to run in a worker thread.  Returns true if W was
+   queued, false if it was already pending, in which case it
+   still runs only once.  May be called from an interrupt
+   handler. */
+bool
+queue_work (struct work *w) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	old_level = intr_disable ();
+	spin_lock (&wq_lock);
+	if (!w->pending) {
+		w->pending = true;
+		enqueue (w);
+		queued = true;
+	}
+	spin_unlock (&wq_lock);
+	if (queued)
+		sema_up (&pending_cnt);
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Queues W to run in a worker thread once at least TICKS timer
+   ticks have passed, or at once if TICKS <= 0.  Returns true if W
+   was queued, false if it was already pending.  May be called
+   from an interrupt handler. */
+bool
+queue_delayed_work (struct work *w, int64_t ticks) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	if (ticks <= 0)
+		return queue_work (w);
+
+	old_level = intr_disable ();
+	spin_lock (&wq_lock);
+	if (!w->pending) {
+		w->pending = true;
+		wheel_insert (&delayed, &w->timer, timer_ticks () + ticks);
+		queued = true;
+	}
+	spin_unlock (&wq_lock);
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Moves delayed work that is due at tick NOW to the pending
+   list.  Called by the timer interrupt handler. */
+void
+workqueue_tick (int64_t now) {
+	int expired_cnt = 0;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* Advance even when the wheel is empty, which costs nothing,
+	   so that its base never falls behind NOW.  Otherwise the
+	   first advance after a quiet stretch would step through
+	   every tick it missed. */
+	spin_lock (&wq_lock);
+	wheel_advance (&delayed, now, expire_delayed, &expired_cnt);
+	spin_unlock (&wq_lock);
+	while (expired_cnt-- > 0)
+		sema_up (&pending_cnt);
+}
+
+/* Returns the tick at which the next delayed work is due, or
+   INT64_MAX if there is none.  Interrupts must be off. */
+int64_t
+workqueue_next_expiry (void) {
+	int64_t expiry;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&wq_lock);
+	expiry = wheel_next_expiry (&delayed);
+	spin_unlock (&wq_lock);
+	return expiry;
+}
+
+/* wheel_action_func for the delayed work wheel, given a count of
+   the work moved to the pending list in EXPIRED_CNT. */
+static void
+expire_delayed (struct wheel_elem *e, void *expired_cnt) {
+	enqueue (wheel_entry (e, struct work, timer));
+	++*(int *) expired_cnt;
+}
+
+/* Appends W to the pending list.  The caller must hold wq_lock,
+   and must then up pending_cnt once it has released it. */
+static void
+enqueue (struct work *w) {
+	ASSERT (spin_held_by_current_cpu (&wq_lock));
+
+	list_push_back (&pending, &w->elem);
+}
+
+/* Worker thread.  Runs pending work, oldest first, forever. */
+static void
+worker_thread (void *aux UNUSED) {
+	for (;;) {
+		enum intr_level old_level;
+		struct work *w;
+
+		sema_down (&pending_cnt);
+		old_level = intr_disable ();
+		spin_lock (&wq_lock);
+		w = list_entry (list_pop_front (&pending), struct work, elem);
+		w->pending = false;
+		spin_unlock (&wq_lock);
+		intr_set_level (old_level);
+
+		w->func (w->aux);
+	}
+}
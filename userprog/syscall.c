@@ -1,9 +1,15 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
+#include <thread-stats.h>
+#include "threads/futex.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
 #include "userprog/gdt.h"
 #include "threads/flags.h"
 #include "intrinsic.h"
@@ -11,6 +17,11 @@
 void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
 
+static int sys_futex (int *uaddr, int op, int val);
+static int *futex_lookup (int *uaddr);
+static int sys_thread_stats (struct thread_stats *ustats);
+static bool copy_out (void *udst, const void *src, size_t size);
+
 /* System call.
  *
  * Previously system call services was handled by the interrupt handler
@@ -39,8 +50,103 @@ syscall_init (void) {
 
 /* The main system call interface */
 void
-syscall_handler (struct intr_frame *f UNUSED) {
-	// TODO: Your implementation goes here.
-	printf ("system call!\n");
-	thread_exit ();
+syscall_handler (struct intr_frame *f) {
+	thread_acct_enter_kernel ();
+
+	/* Arguments arrive in %rdi, %rsi, %rdx, %r10, %r8 and %r9, and
+	 * the result goes back in %rax. */
+	switch (f->R.rax) {
+		case SYS_FUTEX:
+			f->R.rax = sys_futex ((int *) f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_THREAD_STATS:
+			f->R.rax = sys_thread_stats ((struct thread_stats *) f->R.rdi);
+			break;
+		default:
+			// TODO: Your implementation goes here.
+			printf ("system call!\n");
+			thread_exit ();
+	}
+
+	thread_acct_exit_kernel ();
+}
+
+/* futex(): if OP is FUTEX_WAIT, sleeps while *UADDR == VAL; if
+ * FUTEX_WAKE, wakes up to VAL threads sleeping on UADDR.  Returns
+ * -1 if UADDR is not a valid futex. */
+static int
+sys_futex (int *uaddr, int op, int val) {
+	int *futex = futex_lookup (uaddr);
+
+	if (futex == NULL)
+		return -1;
+	switch (op) {
+		case FUTEX_WAIT:
+			return futex_wait (futex, val);
+		case FUTEX_WAKE:
+			return futex_wake (futex, val);
+		default:
+			return -1;
+	}
+}
+
+/* Returns the kernel virtual address of the futex at user
+ * address UADDR in the current process, or a null pointer if
+ * UADDR is misaligned or not mapped. */
+static int *
+futex_lookup (int *uaddr) {
+	struct thread *curr = thread_current ();
+
+	if ((uintptr_t) uaddr % sizeof *uaddr != 0 || !is_user_vaddr (uaddr)
+			|| curr->pml4 == NULL)
+		return NULL;
+	return pml4_get_page (curr->pml4, uaddr);
+}
+
+/* thread_stats(): copies the calling thread's CPU accounting to
+ * USTATS.  Returns 0 if successful, -1 if USTATS is not writable. */
+static int
+sys_thread_stats (struct thread_stats *ustats) {
+	struct thread_stats stats;
+
+	thread_get_stats (&stats);
+	return copy_out (ustats, &stats, sizeof stats) ? 0 : -1;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+ * UDST in the current process.  Returns false, having copied
+ * nothing, if any byte of the destination is not a mapped,
+ * writable user page. */
+static bool
+copy_out (void *udst, const void *src, size_t size) {
+	uint64_t *pml4 = thread_current ()->pml4;
+	uint8_t *dst = udst;
+	uint8_t *page;
+
+	if (pml4 == NULL || dst + size < dst)
+		return false;
+
+	/* Check every page first, so that a fault copies nothing. */
+	for (page = pg_round_down (dst); page < dst + size; page += PGSIZE) {
+		uint64_t *pte;
+
+		if (!is_user_vaddr (page))
+			return false;
+		pte = pml4e_walk (pml4, (uint64_t) page, 0);
+		if (pte == NULL || (*pte & (PTE_P | PTE_U | PTE_W))
+				!= (PTE_P | PTE_U | PTE_W))
+			return false;
+	}
+
+	while (size > 0) {
+		size_t chunk = PGSIZE - pg_ofs (dst);
+
+		if (chunk > size)
+			chunk = size;
+		memcpy (pml4_get_page (pml4, dst), src, chunk);
+		dst += chunk;
+		src = (const uint8_t *) src + chunk;
+		size -= chunk;
+	}
+	return true;
 }